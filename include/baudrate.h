@@ -0,0 +1,52 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   baudrate.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef BAUDRATE_H
+#define BAUDRATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+    /*
+     * termios2 (asm/termbits.h) clashes with <termios.h>, so the baud rate
+     * is set in a translation unit of its own.
+     */
+
+    bool baudrate_is_standard(int baudrate);
+    int  baudrate_set(int fd, int baudrate);
+    int  baudrate_get(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BAUDRATE_H */
@@ -0,0 +1,90 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   clients.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef CLIENTS_H
+#define CLIENTS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+#define CLIENTS_MAX             1024
+#define CLIENTS_INDEX_SIZE      (2 * CLIENTS_MAX)   // power of two, load factor <= 0.5
+#define CLIENTS_IDLE_TIMEOUT_MS 30000
+
+    /**
+     * key of a client: source address (IPv4 is stored v4-mapped) and sysid.
+     * sysid 0 is never used as MAVLink source, the entry with sysid 0 is the
+     * session of the address itself.
+     */
+    typedef struct __client_key_t {
+        uint8_t addr[16];
+        uint16_t port;              // network byte order
+        uint8_t family;
+        uint8_t sysid;
+    } client_key_t;
+
+    typedef struct __client_t {
+        client_key_t key;
+        uint32_t rx_frames;
+        uint32_t tx_frames;
+        uint32_t first;             // session: frames forwarded as first copy
+        uint32_t duplicates;        // session: copies dropped
+        uint32_t lost;              // session: gaps in the seq
+        uint64_t last_seen;         // ms, monotonic
+        void *state;                // per session data of the link (malloc), freed with the client
+    } client_t;
+
+    /**
+     * dense entry array with an open addressing index (linear probing).
+     * index[] holds entry number + 1, 0 is an empty slot.
+     */
+    typedef struct __client_table_t {
+        int count;
+        uint32_t rejected;          // table full
+        client_t entries[CLIENTS_MAX];
+        uint16_t index[CLIENTS_INDEX_SIZE];
+    } client_table_t;
+
+    void clients_init(client_table_t *table);
+    void client_key_from_sockaddr(client_key_t *key, const struct sockaddr_storage *sa, uint8_t sysid);
+    socklen_t client_key_to_sockaddr(const client_key_t *key, struct sockaddr_storage *sa);
+    client_t* clients_lookup(client_table_t *table, const client_key_t *key);
+    client_t* clients_touch(client_table_t *table, const client_key_t *key, uint64_t now_ms, int *created);
+    int  clients_expire(client_table_t *table, uint64_t now_ms, uint64_t idle_ms);
+    const char* client_key_to_string(const client_key_t *key, char *buffer, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLIENTS_H */
@@ -0,0 +1,54 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   convert.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef CONVERT_H
+#define CONVERT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "framer.h"
+#include "option.h"
+
+    typedef struct __convert_stats_t {
+        uint32_t converted;
+        uint32_t saved_bytes;       // by payload truncation
+        uint32_t dropped;           // no v1 representation
+    } convert_stats_t;
+
+    int convert_frame(const mav_frame_t *in, MavVersion version, uint8_t *out, mav_frame_t *frame);
+    const convert_stats_t* convert_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONVERT_H */
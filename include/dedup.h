@@ -0,0 +1,92 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   dedup.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "framer.h"
+
+#define DEDUP_SOURCES   64          // sysid/compid pairs, power of two
+#define DEDUP_WINDOW    64          // frames per source, bits of seen
+
+    /**
+     * the last DEDUP_WINDOW sequence numbers of a source. A frame is a copy
+     * if its seq is marked as seen and the signature (msgid, crc) of that
+     * seq matches.
+     */
+    typedef struct __dedup_source_t {
+        bool used;
+        uint8_t sysid;
+        uint8_t compid;
+        uint8_t top;                // highest seq seen
+        uint64_t seen;              // bit n: seq top - n
+        uint16_t sig[DEDUP_WINDOW]; // by seq % DEDUP_WINDOW
+    } dedup_source_t;
+
+    typedef struct __dedup_t {
+        int count;
+        uint32_t duplicates;
+        uint32_t full;              // sources not tracked, table full
+        dedup_source_t sources[DEDUP_SOURCES];
+    } dedup_t;
+
+    /**
+     * last seq of every source on one link, for the loss counter of the link.
+     * On a server link the session is part of the source (tag).
+     */
+    typedef struct __dedup_seq_t {
+        bool used;
+        uint8_t sysid;
+        uint8_t compid;
+        uint8_t last;
+        uint32_t tag;
+    } dedup_seq_t;
+
+    typedef struct __dedup_link_t {
+        uint32_t first;             // frames forwarded, the first copy came here
+        uint32_t duplicates;        // copies dropped
+        uint32_t lost;              // gaps in the seq of the sources
+        dedup_seq_t seq[DEDUP_SOURCES];
+    } dedup_link_t;
+
+    void dedup_init(dedup_t *d);
+    bool dedup_check(dedup_t *d, const mav_frame_t *frame);
+    int  dedup_count_seq(dedup_link_t *l, const mav_frame_t *frame, uint32_t tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEDUP_H */
@@ -0,0 +1,68 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   event.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef EVENT_H
+#define EVENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <signal.h>
+#include <sys/epoll.h>
+
+#define EVENT_MAX_SOURCES 64
+#define EVENT_MAX_EVENTS  16
+
+    /**
+     * handler of an event source. All sources are registered edge-triggered,
+     * so the handler has to read/write until EAGAIN.
+     */
+    typedef void (*event_handler_t)(int fd, uint32_t events, void *ctx);
+
+    int  event_init(void);
+    int  event_set_nonblocking(int fd);
+    int  event_add(int fd, uint32_t events, event_handler_t handler, void *ctx);
+    int  event_modify(int fd, uint32_t events);
+    int  event_remove(int fd);
+    int  event_add_timer(int interval_ms, event_handler_t handler, void *ctx);
+    int  event_timer_set(int fd, int initial_ms, int interval_ms);
+    uint64_t event_timer_read(int fd);
+    int  event_add_signals(const int *signals, int count, event_handler_t handler, void *ctx);
+    int  event_signal_read(int fd);
+    int  event_run(volatile sig_atomic_t *stop);
+    void event_close(void);
+    uint64_t event_now_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_H */
@@ -0,0 +1,122 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   eventlog.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define EVENTLOG_MAGIC          "MAVEVLOG"
+#define EVENTLOG_VERSION        1
+#define EVENTLOG_ARGS           5
+#define EVENTLOG_DEFAULT_SIZE   (4 * 1024 * 1024)
+#define EVENTLOG_NO_LINK        0xFF
+#define EVENTLOG_RETRY_MS       1000    // next file could not be created, try again
+
+    /**
+     * event ids, the decoder knows them by eventlog_info()
+     */
+    typedef enum {
+        EVENTLOG_NONE = 0,          // unused record, end of the data
+        EVENTLOG_START,             // version
+        EVENTLOG_FRAME_RX,          // msgid, sysid, compid, seq, len
+        EVENTLOG_FRAME_TX,          // msgid, sysid, compid, seq, len
+        EVENTLOG_FRAME_DROP,        // msgid, sysid, compid, reason
+        EVENTLOG_RADIO_STATUS,      // txbuf, rate percent
+        EVENTLOG_LINK_UP,           // - (0)
+        EVENTLOG_LINK_DOWN,         // - (0)
+        EVENTLOG_FEC_RECOVERED,     // datagram length
+        EVENTLOG_COUNT
+    } EventlogEvent;
+
+    typedef enum {
+        EVENTLOG_DROP_UNRESOLVED = 1,   // udp: no address yet
+        EVENTLOG_DROP_STREAM_FULL,      // tcp: send buffer at the high-water mark
+        EVENTLOG_DROP_DOWNSAMPLED,      // serial: telemetry thinned out for the radio
+        EVENTLOG_DROP_FILTERED,         // msgid filter of the link
+        EVENTLOG_DROP_DUPLICATE,        // copy of a redundant link
+        EVENTLOG_DROP_LINK_DOWN,        // serial: port lost, not reopened yet
+    } EventlogDrop;
+
+    /**
+     * file header, followed by the records
+     */
+    typedef struct __eventlog_header_t {
+        char magic[8];              // EVENTLOG_MAGIC
+        uint16_t version;
+        uint16_t record_size;
+        uint32_t reserved;
+        uint64_t realtime_us;       // wall clock ...
+        uint64_t monotonic_us;      // ... at this monotonic time, for absolute times
+        uint8_t pad[32];
+    } eventlog_header_t;
+
+    typedef struct __eventlog_record_t {
+        uint64_t time_us;           // CLOCK_MONOTONIC
+        uint16_t event;
+        uint8_t link;               // link id or EVENTLOG_NO_LINK
+        uint8_t argc;
+        uint32_t arg[EVENTLOG_ARGS];
+    } eventlog_record_t;
+
+    typedef struct __eventlog_info_t {
+        const char *name;
+        const char *args[EVENTLOG_ARGS];
+    } eventlog_info_t;
+
+    /** true while the log is open, checked before the arguments are evaluated */
+    extern bool eventlog_active;
+
+    int  eventlog_open(const char *filename, size_t max_size);
+    void eventlog_close(void);
+    void eventlog_write(uint16_t event, uint8_t link, const uint32_t *args, int argc);
+    const eventlog_info_t* eventlog_info(uint16_t event);
+
+    /**
+     * record an event with 1..EVENTLOG_ARGS numeric arguments, event loop only.
+     * Events without arguments pass 0.
+     */
+#define EVENTLOG(event, link, ...) do { \
+        if (eventlog_active) { \
+            const uint32_t eventlog_args_[] = {__VA_ARGS__}; \
+            eventlog_write((event), (link), eventlog_args_, sizeof (eventlog_args_) / sizeof (uint32_t)); \
+        } \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENTLOG_H */
@@ -0,0 +1,114 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   fec.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef FEC_H
+#define FEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+#include "udp.h"
+
+#define FEC_MAGIC           0xA6    // first byte of a FEC datagram, never a STX
+#define FEC_HEADER_LEN      3       // magic, group, index
+#define FEC_PARITY_HEADER   5       // magic, group, 0x80 | count, length xor
+#define FEC_PARITY          0x80
+#define FEC_MAX_GROUP       32      // data datagrams per parity
+#define FEC_WINDOW_MS       50      // default: a group is closed after this time
+#define FEC_RX_GROUPS       4       // groups decoded at the same time
+#define FEC_MAX_DATA        (UDP_DATAGRAM_SIZE - FEC_PARITY_HEADER)
+
+    typedef struct __fec_stats_t {
+        uint32_t groups;            // parity datagrams sent
+        uint32_t parity_bytes;
+        uint32_t rx_parity;
+        uint32_t recovered;         // lost datagrams rebuilt from the parity
+        uint32_t unrecoverable;     // more than one datagram of a group lost
+        uint32_t late;              // parity after the decode window
+        uint32_t duplicates;
+    } fec_stats_t;
+
+    /**
+     * a group being decoded: the xor of all datagrams and the parity seen
+     * so far. With the parity and all but one datagram it is the missing one.
+     */
+    typedef struct __fec_group_t {
+        bool valid;
+        bool parity;
+        bool done;
+        uint8_t group;
+        uint8_t count;              // data datagrams of the group, from the parity
+        uint16_t len_xor;
+        uint32_t received;          // bitmap of the data datagrams
+        int len;                    // bytes used in acc
+        uint64_t first_ms;
+        uint8_t acc[UDP_DATAGRAM_SIZE];
+    } fec_group_t;
+
+    /**
+     * XOR parity over groups of up to k datagrams to one peer: one lost
+     * datagram per group is rebuilt without a retransmission.
+     */
+    typedef struct __fec_t {
+        int k;                      // data datagrams per parity, 0 = receive only
+        int window_ms;
+        bool seen;                  // the peer sends FEC, it can decode it too
+        fec_stats_t *stats;
+        // group being sent
+        uint8_t group;
+        uint8_t count;
+        uint16_t len_xor;
+        int len;
+        uint64_t first_ms;
+        uint8_t header[UDP_BATCH_SIZE][FEC_HEADER_LEN];
+        uint8_t acc[FEC_PARITY_HEADER + FEC_MAX_DATA];
+        fec_group_t rx[FEC_RX_GROUPS];
+    } fec_t;
+
+    void fec_init(fec_t *f, int k, int window_ms, fec_stats_t *stats);
+    const uint8_t* fec_encode(fec_t *f, int slot, const struct iovec *iov, int iovlen, uint64_t now);
+    bool fec_group_full(const fec_t *f);
+    bool fec_group_open(const fec_t *f);
+    int  fec_parity(fec_t *f, uint8_t *out);
+    int  fec_receive(fec_t *f, const uint8_t *data, int len, uint64_t now,
+            const uint8_t **payload, const uint8_t **recovered, int *recovered_len);
+
+    static inline bool fec_is_fec(const uint8_t *data, int len) {
+        return len >= FEC_HEADER_LEN && data[0] == FEC_MAGIC;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FEC_H */
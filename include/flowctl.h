@@ -0,0 +1,71 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   flowctl.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef FLOWCTL_H
+#define FLOWCTL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "framer.h"
+
+#define FLOWCTL_TXBUF_CRITICAL  20      // % free: halve the rate
+#define FLOWCTL_TXBUF_LOW       50      // % free: reduce the rate by 10%
+#define FLOWCTL_TXBUF_HIGH      90      // % free: increase the rate by FLOWCTL_STEP
+#define FLOWCTL_STEP            5       // % of the line rate
+#define FLOWCTL_MIN_PERCENT     10
+#define FLOWCTL_TIMEOUT_MS      5000    // no RADIO_STATUS: back to the full rate
+
+    /**
+     * closed loop flow control by the free tx buffer a SiK radio reports
+     * in RADIO_STATUS.txbuf
+     */
+    typedef struct __flowctl_t {
+        int percent;            // allowed rate in % of the line rate
+        int txbuf;              // last reported free buffer in %, -1 = none
+        uint64_t last_ms;       // last RADIO_STATUS
+        int credit;             // downsampling of the telemetry
+        uint32_t status_count;
+        uint32_t throttled;     // rate reductions
+        uint32_t downsampled;   // telemetry frames dropped
+    } flowctl_t;
+
+    void flowctl_init(flowctl_t *flow);
+    bool flowctl_radio_status(flowctl_t *flow, const mav_frame_t *frame, uint64_t now);
+    bool flowctl_expire(flowctl_t *flow, uint64_t now);
+    bool flowctl_downsample(flowctl_t *flow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLOWCTL_H */
@@ -0,0 +1,72 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   framebuf.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef FRAMEBUF_H
+#define FRAMEBUF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "framer.h"
+
+#define FRAMEBUF_POOL_SIZE 512     // shared by all links, queues reserve their own on top
+
+    /**
+     * reference counted copy of a frame. A frame is copied once when it is
+     * forwarded, all outputs share the same buffer until they have sent it.
+     */
+    typedef struct __framebuf_t {
+        int refcount;
+        mav_frame_t frame;          // data/payload point into data[]
+        struct __framebuf_t *next;  // free list
+        uint8_t data[MAVLINK_MAX_PACKET_LEN];
+    } framebuf_t;
+
+    typedef struct __framebuf_stats_t {
+        uint32_t size;              // buffers in the pool
+        uint32_t in_use;
+        uint32_t in_use_max;
+        uint32_t exhausted;         // no free buffer, frame dropped
+    } framebuf_stats_t;
+
+    int  framebuf_init(void);
+    int  framebuf_reserve(int count);
+    framebuf_t* framebuf_get(const mav_frame_t *frame);
+    framebuf_t* framebuf_ref(framebuf_t *fb);
+    void framebuf_unref(framebuf_t *fb);
+    const framebuf_stats_t* framebuf_stats(void);
+    void framebuf_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAMEBUF_H */
@@ -0,0 +1,92 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   framer.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef FRAMER_H
+#define FRAMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mavlink_types.h"
+
+#define FRAMER_BUFFER_SIZE (4 * MAVLINK_MAX_PACKET_LEN)
+
+#define MAVLINK_V1_HEADER_LEN (MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1)
+#define MAVLINK_V2_HEADER_LEN (MAVLINK_CORE_HEADER_LEN + 1)
+
+    /**
+     * a complete MAVLink frame found by the framer.
+     * data and payload point into the parsed buffer and are only valid
+     * until the next call of framer_write_ptr() or framer_attach()
+     */
+    typedef struct __mav_frame_t {
+        const uint8_t *data;        // begin of frame (STX)
+        const uint8_t *payload;     // begin of payload
+        uint16_t len;               // complete frame length incl. checksum and signature
+        uint8_t version;            // 1 or 2
+        uint8_t payload_len;
+        uint8_t incompat_flags;     // always 0 for MAVLink v1
+        uint8_t seq;
+        uint8_t sysid;
+        uint8_t compid;
+        uint32_t msgid;
+        const mavlink_msg_entry_t *entry;   // NULL if msgid is unknown
+    } mav_frame_t;
+
+    typedef struct __framer_stats_t {
+        uint32_t frames;
+        uint32_t bad_crc;
+        uint32_t unknown_msgid;
+        uint32_t skipped_bytes;
+    } framer_stats_t;
+
+    typedef struct __framer_t {
+        uint8_t buffer[FRAMER_BUFFER_SIZE];
+        const uint8_t *data;        // buffer or attached external data
+        int len;                    // bytes held in data
+        int pos;                    // parse position
+        framer_stats_t stats;
+    } framer_t;
+
+    void framer_init(framer_t *framer);
+    void framer_attach(framer_t *framer, const uint8_t *data, int len);
+    uint8_t* framer_write_ptr(framer_t *framer, int *space);
+    void framer_commit(framer_t *framer, int len);
+    bool framer_next(framer_t *framer, mav_frame_t *frame);
+    const mavlink_msg_entry_t* framer_msg_entry(uint32_t msgid);
+    bool framer_msgid_from_name(const char *name, uint32_t *msgid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAMER_H */
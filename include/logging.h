@@ -36,10 +36,14 @@ extern "C" {
 #endif
 
 #include <stdio.h>
+#include <stdint.h>
 
 #define LOGFILE_DEFAULT_NAME     "/tmp/mavrpt.log"
 #define LOGFILE_DEFAULT_SIZE     512 * 1024
 #define LOGFILE_DEFAULT_SIZE_MAX 1024 * 1024 // default: 1 MB
+#define LOG_RING_SIZE            1024        // messages waiting for the logging thread, power of two
+#define LOG_RECORD_TEXT          232         // longer messages are cut
+#define LOG_FLUSH_MS             100         // the logging thread writes at least this often
 
 
     typedef enum {
@@ -58,14 +62,31 @@ extern "C" {
     void logSTD();
     const LogLevel loglevel_from_string(const char *string);
     const char* loglevel_to_string(LogLevel level);
+    int log_start(void);
     void log_close();
+    uint32_t log_dropped(void);
     void log_msg(LogLevel level, const char *fmt, ...);
 
-#define LOG__TRACE(...) log_msg(LogLevel_TRACE, __VA_ARGS__)
-#define LOG__DEBUG(...) log_msg(LOGLEVEL_DEBUG, __VA_ARGS__)
-#define LOG__INFO(...) log_msg(LOGLEVEL_INFO,  __VA_ARGS__)
-#define LOG__WARN(...) log_msg(LOGLEVEL_WARN,  __VA_ARGS__)
-#define LOG__ERROR(...) log_msg(LOGLEVEL_ERROR, __VA_ARGS__)
+    /** runtime level, read by the macros before the arguments are evaluated */
+    extern LogLevel log_current_level;
+
+    /*
+     * LOG_MIN_LEVEL is the lowest level compiled in (set by CMake, 0 = TRACE).
+     * Messages below it compile to nothing, the arguments are only type checked.
+     */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+#define LOG__AT(level, ...) do { \
+        if ((level) >= LOG_MIN_LEVEL && (level) >= log_current_level) log_msg((level), __VA_ARGS__); \
+    } while (0)
+
+#define LOG__TRACE(...) LOG__AT(LogLevel_TRACE, __VA_ARGS__)
+#define LOG__DEBUG(...) LOG__AT(LOGLEVEL_DEBUG, __VA_ARGS__)
+#define LOG__INFO(...) LOG__AT(LOGLEVEL_INFO,  __VA_ARGS__)
+#define LOG__WARN(...) LOG__AT(LOGLEVEL_WARN,  __VA_ARGS__)
+#define LOG__ERROR(...) LOG__AT(LOGLEVEL_ERROR, __VA_ARGS__)
 
 
 #ifdef __cplusplus
@@ -36,19 +36,85 @@ extern "C" {
 
 #include <stdbool.h>
 
+#include <stdint.h>
+#include "serial.h"
+
+#define OPTIONS_MAX_ENDPOINTS 16
+#define OPTIONS_MAX_FILTER    32
+#define OPTIONS_MAX_RATES     32
+
+    typedef enum {
+        ENDPOINT_SERIAL,
+        ENDPOINT_UDP,           // send to server:port
+        ENDPOINT_UDP_SERVER,    // listen on port, many clients
+        ENDPOINT_TCP            // connect to server:port
+    } EndpointType;
+
+    typedef enum {
+        DIRECTION_BOTH,
+        DIRECTION_IN,           // only receive from the endpoint
+        DIRECTION_OUT           // only send to the endpoint
+    } Direction;
+
+    typedef enum {
+        MAVVERSION_KEEP,        // forward frames as received
+        MAVVERSION_V1,          // legacy peer: convert v2 to v1
+        MAVVERSION_V2           // convert v1 to v2, truncate v2 payloads
+    } MavVersion;
+
+    typedef struct __endpoint_opt_t {
+        EndpointType type;
+        char device[32];
+        int baudrate;
+        serial_opt_t serial;    // "low_latency", "rtscts", "read_batch", "read_wait_ms"
+        char server[64];
+        int port;
+        Direction direction;
+        bool filter_block;      // filter is a block list, otherwise an allow list
+        int filter_count;       // 0 = no filter
+        uint32_t filter[OPTIONS_MAX_FILTER];    // msgids of frames sent to the endpoint
+        int rate_count;         // 0 = no rate caps
+        uint32_t rate_msgid[OPTIONS_MAX_RATES];
+        float rate_hz[OPTIONS_MAX_RATES];       // max. frames per second sent to the endpoint
+        int mtu;                // udp: coalesce frames into datagrams up to mtu bytes, 0 = off
+        int coalesce_ms;        // udp: deadline of a coalesced datagram
+        MavVersion version;     // "mavlink": "v1" / "v2"
+        bool compress;          // udp: tunnel codec, the other side must enable it too
+        int fec;                // udp: one parity datagram per fec datagrams, 0 = off
+        int fec_ms;             // udp: max. time of a FEC group
+    } endpoint_opt_t;
+
     typedef struct __options_t {
         bool daemon;
         char loglevel[16];
         char loglevel_dflt[16];
         char logfile[256];
         int  logfilesize;
+        char eventlog[256];     // binary event log, "" = off
+        int  eventlogsize;
         char device[32];
         char device_dflt[32];
         int baudrate;
         int baudrate_dflt;
-        char server[32];
+        serial_opt_t serial;    // default serial port
+        char server[64];
         int port;
+        int mtu;                // default udp link: coalesce frames up to mtu bytes
+        int coalesce_ms;
+        MavVersion version;     // default udp link: mavlink version on the tunnel
+        bool compress;          // default udp link: tunnel codec
+        int fec;                // default udp link: datagrams per parity
+        int fec_ms;
+        bool dedup;             // drop copies of frames from redundant links
+        char tlog[200];         // record the received frames into tlogs in this directory, "" = off
+        int tlog_size;          // bytes per tlog file
+        int tlog_minutes;       // new tlog file after this time, 0 = only by size
+        char replay_file[256];  // replay: tlog to feed into the relay
+        double replay_speed;    // replay: 1 = original timing, 0 = as fast as possible
+        int replay_port;        // replay: input by udp on this port, 0 = pty
         char function[32];
+        endpoint_opt_t endpoints[OPTIONS_MAX_ENDPOINTS];    // "endpoints" and "gcs" of the json config
+        int endpoint_count;
     } options_t;
 
     typedef struct __jsonconfig_t {
@@ -62,18 +128,21 @@ extern "C" {
         char* mav_repeater_client;
         char* mav_repeater_server;
         char* mav_repeater;
+        char* mav_repeater_replay;
     } prognames_t;
 
     typedef enum {
         mavrptclient,
         mavrptserver,
-        mavrpt
+        mavrpt,
+        mavrptreplay
     } ProgFunction;
 
     void parse_options(int argc, char *argv[]);
     bool parse_config(int argc, char *argv[]);
     void print_usage();
     void get_program_name(char *argv[]);
+    ProgFunction get_prog_function(void);
     int  load_config_from_json(const char* filename, options_t* cfg, const char* function);
 
 #ifdef __cplusplus
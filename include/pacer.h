@@ -0,0 +1,63 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   pacer.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef PACER_H
+#define PACER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PACER_BURST_MS  20      // bucket depth, at least one frame of max. size
+
+    /**
+     * token bucket, the tokens are kept in 1/1000 bytes so the refill works
+     * with millisecond timestamps at low rates
+     */
+    typedef struct __pacer_t {
+        uint32_t rate;          // bytes per second, 0 = not paced
+        uint64_t tokens;        // milli bytes
+        uint64_t depth;         // milli bytes
+        uint64_t last_ms;
+        uint32_t delayed;       // frames which had to wait for tokens
+    } pacer_t;
+
+    void pacer_init(pacer_t *pacer, int baudrate, int char_bits, uint64_t now);
+    void pacer_set_rate(pacer_t *pacer, uint32_t rate);
+    bool pacer_take(pacer_t *pacer, int len, uint64_t now);
+    int  pacer_wait_ms(const pacer_t *pacer, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PACER_H */
@@ -0,0 +1,88 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   ratecap.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef RATECAP_H
+#define RATECAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "framebuf.h"
+#include "clients.h"
+
+#define RATECAP_MSGIDS   65536      // msgids with a rate cap, like the filter
+#define RATECAP_MAX      32         // rate caps per link
+#define RATECAP_SOURCES  512        // msgid/sysid/compid of all caps of a link, power of two
+
+    /**
+     * one source of a capped message. A frame which comes before its time
+     * is held and replaced by newer ones (latest value wins).
+     */
+    typedef struct __ratecap_source_t {
+        bool used;
+        bool has_peer;
+        uint8_t slot;               // cap of the msgid
+        uint8_t sysid;
+        uint8_t compid;
+        uint64_t next_ms;           // earliest time for the next frame
+        framebuf_t *pending;        // held frame
+        client_key_t peer;          // target session of the held frame
+    } ratecap_source_t;
+
+    typedef struct __ratecap_slot_t {
+        uint32_t msgid;
+        uint32_t interval_ms;
+    } ratecap_slot_t;
+
+    typedef struct __ratecap_t {
+        int count;
+        uint32_t held;              // frames which had to wait
+        uint32_t replaced;          // held frames replaced by a newer one
+        uint32_t full;              // frames dropped, no source entry left
+        int sources_used;
+        uint8_t index[RATECAP_MSGIDS];      // msgid -> slot + 1, 0 = no cap
+        ratecap_slot_t slots[RATECAP_MAX];
+        ratecap_source_t sources[RATECAP_SOURCES];  // hashed by msgid/sysid/compid
+    } ratecap_t;
+
+    ratecap_t* ratecap_create(void);
+    int  ratecap_add(ratecap_t *rc, uint32_t msgid, float hz);
+    bool ratecap_admit(ratecap_t *rc, framebuf_t *fb, const client_key_t *peer, uint64_t now);
+    uint64_t ratecap_next_ms(const ratecap_t *rc);
+    framebuf_t* ratecap_take_due(ratecap_t *rc, uint64_t now, client_key_t *peer, bool *has_peer);
+    void ratecap_free(ratecap_t *rc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RATECAP_H */
@@ -0,0 +1,76 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   recorder.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "framer.h"
+
+#define RECORDER_RING_SLOTS     1024            // frames waiting for the recorder thread, power of two
+#define RECORDER_FLUSH_MS       20              // the thread writes at least this often
+#define RECORDER_DEFAULT_SIZE   (16 * 1024 * 1024)
+#define RECORDER_DEFAULT_MINUTES 60
+
+    /**
+     * one received frame on its way to the recorder thread
+     */
+    typedef struct __recorder_slot_t {
+        uint64_t time_us;           // wall clock of the reception
+        uint16_t len;
+        uint8_t data[MAVLINK_MAX_PACKET_LEN];
+    } recorder_slot_t;
+
+    typedef struct __recorder_stats_t {
+        uint32_t frames;            // written to a tlog
+        uint64_t bytes;
+        uint32_t dropped;           // ring full, the disk is behind
+        uint32_t lost;              // no file could be opened
+        uint32_t files;
+    } recorder_stats_t;
+
+    /** true while recording, checked before recorder_write() is called */
+    extern bool recorder_active;
+
+    int  recorder_open(const char *dir, size_t file_size, int rotate_minutes);
+    void recorder_write(const mav_frame_t *frame);
+    void recorder_close(void);
+    void recorder_status(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RECORDER_H */
@@ -0,0 +1,139 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   relay.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef RELAY_H
+#define RELAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "serial.h"
+#include "udp.h"
+#include "framer.h"
+#include "framebuf.h"
+#include "clients.h"
+#include "ringbuf.h"
+#include "txsched.h"
+#include "flowctl.h"
+#include "ratecap.h"
+#include "tunnel.h"
+#include "dedup.h"
+#include "option.h"
+
+#define RELAY_MAX_LINKS          16
+#define RELAY_STREAM_BUFFER_SIZE 16384
+#define RELAY_STREAM_HIGH_WATER  12288
+#define RELAY_RECONNECT_MS       2000
+#define RELAY_COALESCE_MS        5      // default deadline of a coalesced datagram
+#define RELAY_TX_HELD_MAX        (FRAMEBUF_POOL_SIZE / 8)  // frame buffers one udp link holds until it sends
+
+    typedef enum {
+        LINK_SERIAL,
+        LINK_UDP_CLIENT,        // connected to one remote address
+        LINK_UDP_SERVER,        // bound port, sessions of many clients
+        LINK_TCP_CLIENT         // connects to a remote address, reconnects
+    } LinkType;
+
+    typedef struct __link_t {
+        int id;
+        LinkType type;
+        char name[64];
+        int fd;
+        Direction direction;
+        MavVersion version;         // frames are converted to this version
+        bool filter_block;
+        uint8_t *filter;            // bitmap of msgids < 65536, NULL = no filter
+        ratecap_t *rates;           // per msgid rate caps, NULL = none
+        int rate_fd;                // timer for held frames
+        uint64_t rate_due;          // time the timer is armed for, 0 = not armed
+        serial_port_t serial;       // LINK_SERIAL
+        txsched_t sched;            // LINK_SERIAL
+        flowctl_t flow;             // LINK_SERIAL, RADIO_STATUS of a radio
+        int pace_fd;                // timer, next frame may be sent
+        bool pace_armed;
+        int read_fd;                // timer, reads the bytes below the read batch
+        framer_t framer;
+        udp_batch_t tx;             // LINK_UDP_*
+        framebuf_t *tx_ref[UDP_BATCH_SIZE * UDP_DATAGRAM_FRAMES];  // frames referenced by tx
+        int tx_held;                // frame buffers referenced in tx_ref
+        const framebuf_t *tx_last;  // last one, the sessions of a server share it
+        int mtu;                    // coalesce frames up to mtu bytes, 0 = off
+        int coalesce_ms;            // deadline of a datagram
+        int coalesce_fd;            // timer, -1 = sent at the end of each event
+        bool compress;              // tunnel codec offered / accepted
+        tunnel_t *tunnel;           // LINK_UDP_CLIENT, server sessions keep theirs in client_t
+        tunnel_t *tunnel_queue[UDP_BATCH_SIZE];    // codec datagrams to send with tx
+        int tunnel_queued;
+        tunnel_stats_t tunnel_stats;
+        tunnel_t *tx_peer[UDP_BATCH_SIZE];  // peer of datagram i in tx, NULL = none
+        int fec_k;                  // data datagrams per parity, 0 = no FEC sent
+        int fec_ms;                 // window of a group
+        int fec_fd;                 // timer, closes open groups
+        bool fec_armed;
+        fec_stats_t fec_stats;
+        uint8_t (*parity)[UDP_DATAGRAM_SIZE];   // parity datagrams sent after the batch
+        int parity_len[UDP_BATCH_SIZE];
+        tunnel_t *parity_peer[UDP_BATCH_SIZE];
+        int parity_count;
+        client_table_t *clients;    // LINK_UDP_SERVER
+        ringbuf_t stream_tx;        // LINK_TCP_CLIENT
+        bool connected;
+        int reconnect_fd;
+        char server[64];            // LINK_UDP_CLIENT, LINK_TCP_CLIENT
+        int port;
+        struct sockaddr_storage addr;   // resolved remote address
+        socklen_t addrlen;          // 0 = not resolved yet
+        uint32_t rx_frames;
+        uint32_t tx_frames;
+        uint32_t tx_dropped;
+        uint32_t filtered;
+        dedup_link_t dedup;         // loss and copies of the frames received here
+    } link_t;
+
+    int     relay_init(void);
+    link_t* relay_add_endpoint(const endpoint_opt_t *ep);
+    link_t* relay_add_serial(const char *device, int baudrate, const serial_opt_t *opt);
+    link_t* relay_add_udp_client(const char *host, int port);
+    link_t* relay_add_udp_server(int port);
+    link_t* relay_add_tcp_client(const char *host, int port);
+    int     relay_set_coalesce(link_t *link, int mtu, int deadline_ms);
+    int     relay_set_compress(link_t *link);
+    int     relay_set_fec(link_t *link, int k, int window_ms);
+    void    relay_set_dedup(bool on);
+    void    relay_status(void);
+    void    relay_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RELAY_H */
@@ -0,0 +1,61 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   replay.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "serial.h"
+
+#define REPLAY_UDP_PORT     14560       // default port of the udp input
+#define REPLAY_BATCH        256         // frames per timer tick at full speed
+#define REPLAY_RETRY_MS     1           // input full (pty buffer, socket)
+#define REPLAY_DRAIN_MS     1000        // the relay may finish its queues, then the program ends
+
+    typedef struct __replay_stats_t {
+        uint32_t frames;
+        uint64_t bytes;
+        uint32_t skipped;           // bytes without a frame header in the tlog
+        uint32_t waits;             // input full, frame written later
+    } replay_stats_t;
+
+    int  replay_start(const char *file, double speed, int udp_port, int baudrate, const serial_opt_t *opt);
+    void replay_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPLAY_H */
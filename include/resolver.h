@@ -0,0 +1,56 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   resolver.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sys/socket.h>
+
+#define RESOLVER_MAX_ENTRIES  16
+#define RESOLVER_INTERVAL_MS  (5 * 60 * 1000)     // re-resolve host names
+#define RESOLVER_RETRY_MS     (10 * 1000)         // after a failed lookup
+
+    /**
+     * called in the event loop when the address of a name is known or has changed
+     */
+    typedef void (*resolve_cb_t)(void *ctx, const struct sockaddr *addr, socklen_t addrlen);
+
+    int  resolver_init(void);
+    int  resolver_add(const char *host, int port, int socktype, resolve_cb_t cb, void *ctx);
+    void resolver_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESOLVER_H */
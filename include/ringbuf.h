@@ -0,0 +1,69 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   ringbuf.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+    /**
+     * byte ring buffer, size is a power of two.
+     * head and tail run freely, the index is masked on access.
+     */
+    typedef struct __ringbuf_t {
+        uint8_t *data;
+        size_t size;
+        size_t head;    // write position
+        size_t tail;    // read position
+    } ringbuf_t;
+
+    int    ringbuf_init(ringbuf_t *rb, size_t size);
+    void   ringbuf_free(ringbuf_t *rb);
+    size_t ringbuf_write(ringbuf_t *rb, const uint8_t *data, size_t len);
+    size_t ringbuf_peek(const ringbuf_t *rb, const uint8_t **data);
+    void   ringbuf_consume(ringbuf_t *rb, size_t len);
+
+    static inline size_t ringbuf_used(const ringbuf_t *rb) {
+        return rb->head - rb->tail;
+    }
+
+    static inline size_t ringbuf_space(const ringbuf_t *rb) {
+        return rb->size - (rb->head - rb->tail);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RINGBUF_H */
@@ -0,0 +1,79 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   router.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "clients.h"
+#include "framer.h"
+
+#define ROUTER_MAX_ROUTES      2048
+#define ROUTER_INDEX_SIZE      (2 * ROUTER_MAX_ROUTES)  // power of two
+#define ROUTER_MAX_TARGETS     16
+#define ROUTER_IDLE_TIMEOUT_MS 60000
+#define ROUTER_HOLD_MS         1000     // a route moves only when its link was silent that long
+
+    /**
+     * where a (sysid, compid) was seen last. Routes of the same system
+     * are chained, so a target with component 0 finds all of them.
+     */
+    typedef struct __route_t {
+        client_key_t peer;          // session on a server link, zero otherwise
+        uint16_t link;
+        uint8_t sysid;
+        uint8_t compid;
+        int16_t next;               // next route of the same sysid, -1 = end
+        uint64_t last_seen;
+    } route_t;
+
+    typedef struct __router_t {
+        int count;
+        uint32_t rejected;          // table full
+        int16_t systems[256];       // first route of a sysid, -1 = unknown
+        route_t routes[ROUTER_MAX_ROUTES];
+        uint16_t index[ROUTER_INDEX_SIZE];
+    } router_t;
+
+    void router_init(router_t *router);
+    void router_learn(router_t *router, const mav_frame_t *frame, uint16_t link, const client_key_t *peer, uint64_t now_ms);
+    bool router_get_target(const mav_frame_t *frame, uint8_t *target_system, uint8_t *target_component);
+    int  router_find(const router_t *router, uint8_t sysid, uint8_t compid, const route_t **routes, int max);
+    int  router_expire(router_t *router, uint64_t now_ms, uint64_t idle_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROUTER_H */
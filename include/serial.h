@@ -36,12 +36,88 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include "ringbuf.h"
+#include "spsc.h"
+#include "framer.h"
 
-    int openSerial(const char* device, int baudrate);
-    int readSerial(int fd, uint8_t* buffer, int buffer_size);
-    int writeSerial(int fd, uint8_t* buffer, int len);
-    void closeSerial(int fd);
-    void statusSerial();
+#define SERIAL_TX_BUFFER_SIZE 8192
+#define SERIAL_TX_HIGH_WATER  6144      // frames above this queue depth are dropped
+#define SERIAL_CHAR_BITS      10        // 8N1: start bit, 8 data bits, stop bit
+#define SERIAL_READ_WAIT_MS   5         // default max. delay of batched reads
+#define SERIAL_RING_SLOTS     256       // frames between the event loop and the i/o threads
+#define SERIAL_RING_WAIT_MS   1         // reader retry at the full rx ring
+
+    /**
+     * tuning of a port, all off / 0 is the classic setup
+     */
+    typedef struct __serial_opt_t {
+        bool low_latency;           // ASYNC_LOW_LATENCY, USB adapters skip their latency timer
+        bool rtscts;                // hardware flow control
+        int read_batch;             // VMIN: readable when this many bytes are waiting, 0/1 = every byte
+        int read_wait_ms;           // with read_batch: the rest is read after this time
+        bool threaded;              // reader and writer thread instead of the event loop
+    } serial_opt_t;
+
+    /**
+     * one frame in the rings of the threaded mode
+     */
+    typedef struct __serial_slot_t {
+        mav_frame_t frame;          // rx: parsed header, data and payload point into buf
+        uint16_t len;
+        uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    } serial_slot_t;
+
+    typedef struct __serial_stats_t {
+        uint64_t rx_bytes;
+        uint64_t tx_bytes;          // written to the tty
+        uint32_t tx_frames;         // accepted into the tx queue
+        uint32_t tx_dropped;        // rejected at the high-water mark
+        uint32_t tx_queue_max;      // peak queue depth in bytes
+        uint32_t reads;             // read() calls which returned data
+        uint32_t read_max;          // most bytes of one read()
+        uint32_t rx_dropped;        // threaded: frames of the reader left at close
+    } serial_stats_t;
+
+    typedef struct __serial_port_t {
+        int fd;
+        char device[32];
+        int baudrate;
+        int char_bits;              // bits on the line per byte
+        serial_opt_t opt;
+        bool low_latency;           // ASYNC_LOW_LATENCY accepted by the driver
+        ringbuf_t tx;
+        size_t tx_high_water;
+        serial_stats_t stats;
+        // threaded mode, see startSerial()
+        bool threaded;
+        pthread_t reader;
+        pthread_t writer;
+        framer_t *framer;           // owned by the reader thread while it runs
+        spsc_t rx_ring;             // reader thread -> event loop
+        spsc_t tx_ring;             // event loop -> writer thread
+        uint64_t tx_handed;         // bytes put into tx_ring
+        uint16_t tx_done;           // bytes of the front tx slot already written
+        int notify_fd;              // eventfd: frames received, tx ring drained, port failed
+        int wake_fd;                // eventfd: frames for an idle writer
+        int stop_fd;                // eventfd: both threads end
+        bool writer_idle;           // writer waits for wake_fd
+        bool tx_wait;               // event loop waits for the tx ring to drain
+        bool failed;                // hangup or read error in the reader
+    } serial_port_t;
+
+    int openSerial(serial_port_t* port, const char* device, int baudrate, const serial_opt_t* opt);
+    int readSerial(serial_port_t* port, uint8_t* buffer, int buffer_size);
+    int writeSerial(serial_port_t* port, const uint8_t* buffer, int len);
+    int flushSerial(serial_port_t* port);
+    size_t queuedSerial(serial_port_t* port);
+    int startSerial(serial_port_t* port, framer_t* framer);
+    const mav_frame_t* receiveSerial(serial_port_t* port);
+    void releaseSerial(serial_port_t* port);
+    bool waitSerial(serial_port_t* port);
+    bool failedSerial(serial_port_t* port);
+    void closeSerial(serial_port_t* port);
+    void statusSerial(serial_port_t* port);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,113 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   spsc.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef SPSC_H
+#define SPSC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SPSC_CACHE_LINE 64
+
+    /**
+     * lock-free ring of preallocated slots between exactly one producer and
+     * one consumer thread. count is a power of two, head and tail run freely.
+     * Each side keeps its index and a copy of the other index on its own
+     * cache line, so the lines only move between the cores when the copy is
+     * outdated.
+     */
+    typedef struct __spsc_t {
+        // producer
+        uint32_t head __attribute__((aligned(SPSC_CACHE_LINE)));   // next slot to write
+        uint32_t tail_cache;        // tail as last seen by the producer
+        // consumer
+        uint32_t tail __attribute__((aligned(SPSC_CACHE_LINE)));   // next slot to read
+        uint32_t head_cache;        // head as last seen by the consumer
+        // constant after spsc_init()
+        uint8_t *slots __attribute__((aligned(SPSC_CACHE_LINE)));
+        uint32_t mask;
+        uint32_t slot_size;         // rounded up to whole cache lines
+    } spsc_t;
+
+    int  spsc_init(spsc_t *q, uint32_t count, uint32_t slot_size);
+    void spsc_free(spsc_t *q);
+
+    /**
+     * producer: the next free slot, NULL if the ring is full.
+     * It becomes visible to the consumer with spsc_publish().
+     */
+    static inline void* spsc_claim(spsc_t *q) {
+        if (q->head - q->tail_cache > q->mask) {
+            q->tail_cache = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+            if (q->head - q->tail_cache > q->mask) {
+                return NULL;
+            }
+        }
+        return q->slots + (size_t) (q->head & q->mask) * q->slot_size;
+    }
+
+    static inline void spsc_publish(spsc_t *q) {
+        __atomic_store_n(&q->head, q->head + 1, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * consumer: the oldest slot, NULL if the ring is empty.
+     * It stays valid until spsc_pop().
+     */
+    static inline void* spsc_front(spsc_t *q) {
+        if (q->tail == q->head_cache) {
+            q->head_cache = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+            if (q->tail == q->head_cache) {
+                return NULL;
+            }
+        }
+        return q->slots + (size_t) (q->tail & q->mask) * q->slot_size;
+    }
+
+    static inline void spsc_pop(spsc_t *q) {
+        __atomic_store_n(&q->tail, q->tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * usable from both sides
+     */
+    static inline bool spsc_empty(spsc_t *q) {
+        return __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPSC_H */
@@ -0,0 +1,135 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   tunnel.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef TUNNEL_H
+#define TUNNEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+#include "framer.h"
+#include "udp.h"
+#include "fec.h"
+
+#define TUNNEL_MAGIC        0xA5    // first byte of a codec datagram, never a STX
+#define TUNNEL_VERSION      1       // codec version of this build
+#define TUNNEL_CONTROL      0       // version byte of handshake datagrams
+#define TUNNEL_HELLO        1
+#define TUNNEL_HELLO_ACK    2
+#define TUNNEL_CONTROL_LEN  4
+#define TUNNEL_HEADER_LEN   3       // magic, version, epoch of a data datagram
+#define TUNNEL_HELLO_MS     5000    // the codec is offered again after this time
+#define TUNNEL_MTU          1200    // datagram size if the link does not coalesce
+#define TUNNEL_STREAMS      64      // payload references, power of two
+#define TUNNEL_KEY_INTERVAL 16      // full payload at least every n frames of a stream
+
+    /**
+     * last full payload of a stream (sysid, compid, msgid). Deltas refer to
+     * it by its key number, so a lost datagram never corrupts later frames.
+     */
+    typedef struct __tunnel_stream_t {
+        bool valid;
+        uint8_t sysid;
+        uint8_t compid;
+        uint8_t key;
+        uint8_t since_key;          // encoder: frames sent as delta since the key
+        uint8_t len;
+        uint32_t msgid;
+        uint8_t payload[MAVLINK_MAX_PAYLOAD_LEN];
+    } tunnel_stream_t;
+
+    typedef struct __tunnel_stats_t {
+        uint32_t tx_frames;
+        uint32_t keys;
+        uint32_t deltas;
+        uint64_t raw_bytes;         // size of the encoded frames
+        uint64_t coded_bytes;       // size of the codec datagrams
+        uint32_t rx_frames;
+        uint32_t no_ref;            // delta without its key, dropped
+        uint32_t bad;               // malformed records
+    } tunnel_stats_t;
+
+    /**
+     * state of one peer of the tunnel: codec and FEC. Encoder and decoder
+     * are independent, the header context (source, sequence) only spans one
+     * datagram.
+     */
+    typedef struct __tunnel_t {
+        uint8_t version;            // agreed with the peer, 0 = raw frames
+        uint8_t epoch;              // encoder, changes with every tunnel_init()
+        uint8_t rx_epoch;
+        bool queued;                // out is in the send queue of the link
+        uint64_t hello_ms;          // last offer
+        tunnel_stats_t *stats;
+        struct sockaddr_storage addr;   // peer of a server session
+        socklen_t addrlen;
+        // datagram being built
+        int out_len;
+        uint8_t out[UDP_DATAGRAM_SIZE];
+        uint8_t out_sysid;
+        uint8_t out_compid;
+        uint8_t out_seq;
+        // datagram being decoded
+        const uint8_t *in;
+        int in_len;
+        int in_pos;
+        uint8_t in_sysid;
+        uint8_t in_compid;
+        uint8_t in_seq;
+        uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+        framer_t raw;               // frames sent without compression
+        tunnel_stream_t tx[TUNNEL_STREAMS];
+        tunnel_stream_t rx[TUNNEL_STREAMS];
+        fec_t fec;
+    } tunnel_t;
+
+    void tunnel_init(tunnel_t *t, tunnel_stats_t *stats);
+    int  tunnel_hello(uint8_t *out);
+    int  tunnel_control(tunnel_t *t, const uint8_t *data, int len, uint8_t *reply);
+    int  tunnel_encode(tunnel_t *t, const mav_frame_t *frame, int mtu);
+    void tunnel_sent(tunnel_t *t);
+    bool tunnel_attach(tunnel_t *t, const uint8_t *data, int len);
+    bool tunnel_next(tunnel_t *t, mav_frame_t *frame);
+
+    /**
+     * datagram of the codec (data or handshake), raw frames begin with a STX
+     */
+    static inline bool tunnel_is_codec(const uint8_t *data, int len) {
+        return len >= 2 && data[0] == TUNNEL_MAGIC;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TUNNEL_H */
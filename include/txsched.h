@@ -0,0 +1,96 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   txsched.h
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#ifndef TXSCHED_H
+#define TXSCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "framebuf.h"
+#include "serial.h"
+#include "pacer.h"
+
+#define TXSCHED_QUEUE_LEN   64          // frames per class, power of two
+#define TXSCHED_BUDGET_MS   1000        // max. queueing delay before frames are dropped
+#define TXSCHED_INFLIGHT    MAVLINK_MAX_PACKET_LEN  // bytes handed to the serial port ahead
+
+    /**
+     * priority classes, lower value = higher priority. CONTROL and TELEMETRY
+     * are served strictly by priority, the bulk classes share the rest by
+     * weight (deficit round robin).
+     */
+    typedef enum {
+        TXSCHED_CONTROL,        // commands, rc override, heartbeat
+        TXSCHED_TELEMETRY,      // everything else
+        TXSCHED_PARAM,          // bulk: parameter transfer
+        TXSCHED_MISSION,        // bulk: mission transfer
+        TXSCHED_FILE,           // bulk: ftp and log download
+        TXSCHED_CLASSES
+    } TxClass;
+
+#define TXSCHED_FIRST_BULK TXSCHED_PARAM
+
+    typedef struct __txsched_entry_t {
+        framebuf_t *fb;
+        uint64_t time_ms;       // enqueued
+    } txsched_entry_t;
+
+    typedef struct __txsched_queue_t {
+        uint32_t head;
+        uint32_t tail;
+        int deficit;            // bulk classes
+        uint32_t bytes;
+        uint32_t sent;
+        uint32_t dropped;       // queue full or over the time budget
+        txsched_entry_t entries[TXSCHED_QUEUE_LEN];
+    } txsched_queue_t;
+
+    typedef struct __txsched_t {
+        uint32_t bytes;         // queued in all classes
+        int bulk;               // current bulk class of the round robin
+        bool bulk_visited;      // quantum of the current class already added
+        pacer_t pacer;          // line rate of the port
+        txsched_queue_t queue[TXSCHED_CLASSES];
+    } txsched_t;
+
+    void txsched_init(txsched_t *sched, const serial_port_t *port, uint64_t now);
+    TxClass txsched_classify(uint32_t msgid);
+    int  txsched_enqueue(txsched_t *sched, framebuf_t *fb, uint64_t now);
+    int  txsched_drain(txsched_t *sched, serial_port_t *port, uint64_t now);
+    void txsched_status(const txsched_t *sched, const char *name);
+    void txsched_clear(txsched_t *sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TXSCHED_H */
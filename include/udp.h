@@ -36,12 +36,43 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define UDP_BATCH_SIZE      16
+#define UDP_DATAGRAM_SIZE   2048
+#define UDP_DATAGRAM_FRAMES 32      // frames coalesced into one datagram
+
+    /**
+     * preallocated message vectors for recvmmsg/sendmmsg.
+     * On receive the datagrams are stored in buffer[] (only allocated for
+     * receive batches), on send iov[] points to the caller's data, which
+     * must be valid until udp_send_batch(). A datagram to send may gather
+     * up to UDP_DATAGRAM_FRAMES pieces and a header in front of them.
+     */
+    typedef struct __udp_batch_t {
+        int count;
+        uint32_t dropped;           // datagrams sendmmsg could not take
+        uint32_t datagrams;         // sent
+        uint32_t frames;            // sent in these datagrams
+        struct mmsghdr msgs[UDP_BATCH_SIZE];
+        struct iovec iov[UDP_BATCH_SIZE][UDP_DATAGRAM_FRAMES + 1];
+        int len[UDP_BATCH_SIZE];    // bytes of datagram i
+        bool header[UDP_BATCH_SIZE];    // iov[i][0] is a header, no frame
+        struct sockaddr_storage addr[UDP_BATCH_SIZE];
+        uint8_t (*buffer)[UDP_DATAGRAM_SIZE];
+    } udp_batch_t;
 
-int setup_udp_client_socket(const char* remote_ip, int port); // zum Senden
 int setup_udp_server_socket(int port);                 // zum Empfangen
+int udp_connect(const struct sockaddr* addr, socklen_t addrlen);
 
-int send_udp_packet(int sockfd, const uint8_t* data, int len);
-int recv_udp_packet(int sockfd, uint8_t* buffer, int maxlen);
+int  udp_batch_init(udp_batch_t* batch, bool rx);
+void udp_batch_free(udp_batch_t* batch);
+int  udp_recv_batch(int sockfd, udp_batch_t* batch);
+int  udp_batch_add(udp_batch_t* batch, const uint8_t* data, int len, const struct sockaddr* addr, socklen_t addrlen, int mtu);
+void udp_batch_prepend(udp_batch_t* batch, int i, const uint8_t* data, int len);
+int  udp_send_batch(int sockfd, udp_batch_t* batch);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,99 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   baudrate.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "baudrate.h"
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+#include <stddef.h>
+
+typedef struct {
+    int baudrate;
+    unsigned int speed;
+} baud_entry_t;
+
+// the Bxxx rates the kernel knows, drivers handle these without rounding
+static const baud_entry_t standard[] = {
+    {50, B50}, {75, B75}, {110, B110}, {134, B134}, {150, B150}, {200, B200},
+    {300, B300}, {600, B600}, {1200, B1200}, {1800, B1800}, {2400, B2400},
+    {4800, B4800}, {9600, B9600}, {19200, B19200}, {38400, B38400},
+    {57600, B57600}, {115200, B115200}, {230400, B230400}, {460800, B460800},
+    {500000, B500000}, {576000, B576000}, {921600, B921600}, {1000000, B1000000},
+    {1152000, B1152000}, {1500000, B1500000}, {2000000, B2000000},
+    {2500000, B2500000}, {3000000, B3000000}, {3500000, B3500000},
+    {4000000, B4000000},
+};
+
+static const baud_entry_t* find_standard(int baudrate) {
+    for (size_t i = 0; i < sizeof (standard) / sizeof (standard[0]); i++) {
+        if (standard[i].baudrate == baudrate) {
+            return &standard[i];
+        }
+    }
+    return NULL;
+}
+
+bool baudrate_is_standard(int baudrate) {
+    return find_standard(baudrate) != NULL;
+}
+
+/**
+ * set the baud rate of a tty, a Bxxx constant if there is one, otherwise
+ * the rate itself (BOTHER). The other settings of the tty are kept.
+ * @param fd
+ * @param baudrate
+ * @return the rate the driver applied, -1 on error
+ */
+int baudrate_set(int fd, int baudrate) {
+    const baud_entry_t *entry = find_standard(baudrate);
+    struct termios2 tio;
+
+    if (baudrate <= 0 || ioctl(fd, TCGETS2, &tio) < 0) {
+        return -1;
+    }
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= entry ? entry->speed : BOTHER;
+    tio.c_ispeed = baudrate;
+    tio.c_ospeed = baudrate;
+    if (ioctl(fd, TCSETS2, &tio) < 0) {
+        return -1;
+    }
+    return baudrate_get(fd);
+}
+
+/**
+ * @param fd
+ * @return the output rate of the tty as the driver reports it, -1 on error
+ */
+int baudrate_get(int fd) {
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio) < 0) {
+        return -1;
+    }
+    return (int) tio.c_ospeed;
+}
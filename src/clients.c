@@ -0,0 +1,235 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   clients.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "clients.h"
+#include "logging.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static const uint8_t v4mapped_prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+/**
+ * initialize an empty client table
+ * @param table
+ */
+void clients_init(client_table_t *table) {
+    table->count = 0;
+    table->rejected = 0;
+    memset(table->index, 0, sizeof (table->index));
+}
+
+/**
+ * build the key of a source address
+ * @param key
+ * @param sa
+ * @param sysid
+ */
+void client_key_from_sockaddr(client_key_t *key, const struct sockaddr_storage *sa, uint8_t sysid) {
+    memset(key, 0, sizeof (*key));
+    if (sa->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *in6 = (const struct sockaddr_in6*) sa;
+        memcpy(key->addr, &in6->sin6_addr, 16);
+        key->port = in6->sin6_port;
+    } else {
+        const struct sockaddr_in *in = (const struct sockaddr_in*) sa;
+        memcpy(key->addr, v4mapped_prefix, 12);
+        memcpy(key->addr + 12, &in->sin_addr, 4);
+        key->port = in->sin_port;
+    }
+    key->family = (uint8_t) sa->ss_family;
+    key->sysid = sysid;
+}
+
+/**
+ * build the destination address of a client
+ * @param key
+ * @param sa
+ * @return length of the address
+ */
+socklen_t client_key_to_sockaddr(const client_key_t *key, struct sockaddr_storage *sa) {
+    memset(sa, 0, sizeof (*sa));
+    if (key->family == AF_INET6) {
+        struct sockaddr_in6 *in6 = (struct sockaddr_in6*) sa;
+        in6->sin6_family = AF_INET6;
+        memcpy(&in6->sin6_addr, key->addr, 16);
+        in6->sin6_port = key->port;
+        return sizeof (*in6);
+    }
+    struct sockaddr_in *in = (struct sockaddr_in*) sa;
+    in->sin_family = AF_INET;
+    memcpy(&in->sin_addr, key->addr + 12, 4);
+    in->sin_port = key->port;
+    return sizeof (*in);
+}
+
+const char* client_key_to_string(const client_key_t *key, char *buffer, int size) {
+    char ip[INET6_ADDRSTRLEN];
+    // clients of a dual stack socket are AF_INET6 with a v4-mapped address
+    if (key->family == AF_INET6 && memcmp(key->addr, v4mapped_prefix, 12) != 0) {
+        inet_ntop(AF_INET6, key->addr, ip, sizeof (ip));
+    } else {
+        inet_ntop(AF_INET, key->addr + 12, ip, sizeof (ip));
+    }
+    snprintf(buffer, size, "%s:%u sysid %u", ip, ntohs(key->port), key->sysid);
+    return buffer;
+}
+
+static uint32_t key_hash(const client_key_t *key) {
+    // FNV-1a over the key
+    const uint8_t *p = (const uint8_t*) key;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof (*key); i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline int key_equal(const client_key_t *a, const client_key_t *b) {
+    return memcmp(a, b, sizeof (*a)) == 0;
+}
+
+/**
+ * returns the index slot of key, or the empty slot where it belongs
+ */
+static uint32_t find_slot(const client_table_t *table, const client_key_t *key) {
+    uint32_t mask = CLIENTS_INDEX_SIZE - 1;
+    uint32_t slot = key_hash(key) & mask;
+    while (table->index[slot] != 0) {
+        if (key_equal(&table->entries[table->index[slot] - 1].key, key)) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * lookup a client
+ * @param table
+ * @param key
+ * @return client or NULL
+ */
+client_t* clients_lookup(client_table_t *table, const client_key_t *key) {
+    uint32_t slot = find_slot(table, key);
+    if (table->index[slot] == 0) {
+        return NULL;
+    }
+    return &table->entries[table->index[slot] - 1];
+}
+
+/**
+ * lookup a client and refresh it, a new client is inserted
+ * @param table
+ * @param key
+ * @param now_ms
+ * @param created set to 1 if the client is new (may be NULL)
+ * @return client or NULL if the table is full
+ */
+client_t* clients_touch(client_table_t *table, const client_key_t *key, uint64_t now_ms, int *created) {
+    uint32_t slot = find_slot(table, key);
+    client_t *client;
+
+    if (created) *created = 0;
+    if (table->index[slot] != 0) {
+        client = &table->entries[table->index[slot] - 1];
+    } else {
+        if (table->count >= CLIENTS_MAX) {
+            table->rejected++;
+            return NULL;
+        }
+        client = &table->entries[table->count];
+        memset(client, 0, sizeof (*client));
+        client->key = *key;
+        table->index[slot] = (uint16_t) (++table->count);
+        if (created) *created = 1;
+    }
+    client->last_seen = now_ms;
+    return client;
+}
+
+/**
+ * remove the entry at index slot (backward shift deletion)
+ */
+static void remove_slot(client_table_t *table, uint32_t slot) {
+    uint32_t mask = CLIENTS_INDEX_SIZE - 1;
+    uint32_t hole = slot;
+    uint32_t next = (slot + 1) & mask;
+
+    table->index[hole] = 0;
+    while (table->index[next] != 0) {
+        uint32_t home = key_hash(&table->entries[table->index[next] - 1].key) & mask;
+        // move the entry into the hole if its home is not between hole and next
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table->index[hole] = table->index[next];
+            table->index[next] = 0;
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+}
+
+/**
+ * remove clients not seen for idle_ms
+ * @param table
+ * @param now_ms
+ * @param idle_ms
+ * @return number of removed clients
+ */
+int clients_expire(client_table_t *table, uint64_t now_ms, uint64_t idle_ms) {
+    int removed = 0;
+    int i = 0;
+
+    while (i < table->count) {
+        client_t *client = &table->entries[i];
+        if (now_ms - client->last_seen < idle_ms) {
+            i++;
+            continue;
+        }
+
+        char name[80];
+        LOG__INFO("client %s expired", client_key_to_string(&client->key, name, sizeof (name)));
+        remove_slot(table, find_slot(table, &client->key));
+        free(client->state);
+
+        // keep the entries dense: move the last entry into the gap
+        int last = table->count - 1;
+        if (i != last) {
+            uint32_t slot = find_slot(table, &table->entries[last].key);
+            table->entries[i] = table->entries[last];
+            table->index[slot] = (uint16_t) (i + 1);
+        }
+        table->count--;
+        removed++;
+    }
+    return removed;
+}
@@ -0,0 +1,148 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   convert.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "convert.h"
+#include "common/mavlink.h"
+#include <string.h>
+
+/*
+ * Re-encode frames between MAVLink v1 and v2 directly on the wire bytes:
+ * copy header fields and payload, recompute the checksum. No
+ * mavlink_message_t, no field decoding.
+ */
+
+static convert_stats_t stats;
+
+static int finish(uint8_t *out, int header_len, uint8_t crc_extra, mav_frame_t *frame) {
+    int plen = out[1];
+    uint16_t crc = crc_calculate(out + 1, header_len - 1 + plen);
+    crc_accumulate(crc_extra, &crc);
+    out[header_len + plen] = (uint8_t) (crc & 0xFF);
+    out[header_len + plen + 1] = (uint8_t) (crc >> 8);
+
+    frame->data = out;
+    frame->payload = out + header_len;
+    frame->payload_len = plen;
+    frame->len = header_len + plen + MAVLINK_NUM_CHECKSUM_BYTES;
+    stats.converted++;
+    return frame->len;
+}
+
+/**
+ * v2 with the trailing zeros of the payload removed (at least one byte stays)
+ */
+static int to_v2(const mav_frame_t *in, uint8_t *out, mav_frame_t *frame) {
+    int plen = in->payload_len;
+    while (plen > 1 && in->payload[plen - 1] == 0) {
+        plen--;
+    }
+    if (in->version == 2 && plen == in->payload_len) {
+        return 0;
+    }
+
+    out[0] = MAVLINK_STX;
+    out[1] = (uint8_t) plen;
+    out[2] = 0;                                     // incompat flags, not signed
+    out[3] = (in->version == 2) ? in->data[3] : 0;  // compat flags
+    out[4] = in->seq;
+    out[5] = in->sysid;
+    out[6] = in->compid;
+    out[7] = (uint8_t) (in->msgid & 0xFF);
+    out[8] = (uint8_t) ((in->msgid >> 8) & 0xFF);
+    out[9] = (uint8_t) ((in->msgid >> 16) & 0xFF);
+    memcpy(out + MAVLINK_V2_HEADER_LEN, in->payload, plen);
+
+    *frame = *in;
+    frame->version = 2;
+    frame->incompat_flags = 0;
+    stats.saved_bytes += in->len - (MAVLINK_V2_HEADER_LEN + plen + MAVLINK_NUM_CHECKSUM_BYTES);
+    return finish(out, MAVLINK_V2_HEADER_LEN, in->entry->crc_extra, frame);
+}
+
+/**
+ * v1: only messages < 256 without extension fields, a truncated payload
+ * is filled up with zeros again
+ */
+static int to_v1(const mav_frame_t *in, uint8_t *out, mav_frame_t *frame) {
+    int plen = in->entry->min_msg_len;
+    int copy = (in->payload_len < plen) ? in->payload_len : plen;
+
+    out[0] = MAVLINK_STX_MAVLINK1;
+    out[1] = (uint8_t) plen;
+    out[2] = in->seq;
+    out[3] = in->sysid;
+    out[4] = in->compid;
+    out[5] = (uint8_t) in->msgid;
+    memcpy(out + MAVLINK_V1_HEADER_LEN, in->payload, copy);
+    memset(out + MAVLINK_V1_HEADER_LEN + copy, 0, plen - copy);
+
+    *frame = *in;
+    frame->version = 1;
+    frame->incompat_flags = 0;
+    return finish(out, MAVLINK_V1_HEADER_LEN, in->entry->crc_extra, frame);
+}
+
+/**
+ * convert a frame for a link
+ * @param in
+ * @param version MAVVERSION_V2: upgrade v1 and truncate v2, MAVVERSION_V1: downgrade v2
+ * @param out buffer of MAVLINK_MAX_PACKET_LEN bytes
+ * @param frame the converted frame in out
+ * @return length of the converted frame, 0 if in can be sent unchanged,
+ *         -1 if there is no representation in the requested version
+ */
+int convert_frame(const mav_frame_t *in, MavVersion version, uint8_t *out, mav_frame_t *frame) {
+    bool is_signed = (in->incompat_flags & MAVLINK_IFLAG_SIGNED) != 0;
+
+    switch (version) {
+        case MAVVERSION_V2:
+            // a signature covers header and payload, signed frames stay as they are
+            if (!in->entry || is_signed) {
+                return 0;
+            }
+            return to_v2(in, out, frame);
+
+        case MAVVERSION_V1:
+            if (in->version == 1) {
+                return 0;
+            }
+            if (!in->entry || in->msgid > 255 || is_signed) {
+                stats.dropped++;
+                return -1;
+            }
+            return to_v1(in, out, frame);
+
+        default:
+            return 0;
+    }
+}
+
+const convert_stats_t* convert_stats(void) {
+    return &stats;
+}
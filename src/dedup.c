@@ -0,0 +1,149 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   dedup.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "dedup.h"
+#include "common/mavlink.h"
+#include <string.h>
+
+static inline uint32_t source_hash(uint8_t sysid, uint8_t compid, uint32_t tag) {
+    return ((sysid * 31u + compid) ^ tag) & (DEDUP_SOURCES - 1);
+}
+
+/**
+ * checksum and msgid of a frame folded into 16 bit
+ */
+static inline uint16_t frame_sig(const mav_frame_t *frame) {
+    int crc_pos = frame->len - MAVLINK_NUM_CHECKSUM_BYTES;
+    if (frame->incompat_flags & MAVLINK_IFLAG_SIGNED) {
+        crc_pos -= MAVLINK_SIGNATURE_BLOCK_LEN;
+    }
+    uint16_t crc = frame->data[crc_pos] | (frame->data[crc_pos + 1] << 8);
+    return crc ^ (uint16_t) (frame->msgid * 0x9E37u);
+}
+
+void dedup_init(dedup_t *d) {
+    memset(d, 0, sizeof (*d));
+}
+
+static dedup_source_t* find_source(dedup_t *d, uint8_t sysid, uint8_t compid, bool *created) {
+    uint32_t i = source_hash(sysid, compid, 0);
+
+    *created = false;
+    for (int n = 0; n < DEDUP_SOURCES; n++, i = (i + 1) & (DEDUP_SOURCES - 1)) {
+        dedup_source_t *s = &d->sources[i];
+        if (!s->used) {
+            s->used = true;
+            s->sysid = sysid;
+            s->compid = compid;
+            d->count++;
+            *created = true;
+            return s;
+        }
+        if (s->sysid == sysid && s->compid == compid) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * check if a frame is the first copy. The same frame comes again over
+ * redundant links, a copy has the same (sysid, compid, seq, msgid, crc).
+ * @param d
+ * @param frame
+ * @return true for the first copy, false for a duplicate
+ */
+bool dedup_check(dedup_t *d, const mav_frame_t *frame) {
+    bool created;
+    dedup_source_t *s = find_source(d, frame->sysid, frame->compid, &created);
+    if (!s) {
+        d->full++;
+        return true;
+    }
+
+    uint16_t sig = frame_sig(frame);
+    uint8_t seq = frame->seq;
+    uint8_t ahead = (uint8_t) (seq - s->top);
+
+    if (created) {
+        s->top = seq;
+        s->seen = 1;
+    } else if (ahead != 0 && ahead < 128) {
+        // newer frame, move the window
+        s->seen = (ahead >= DEDUP_WINDOW) ? 1 : (s->seen << ahead) | 1;
+        s->top = seq;
+    } else {
+        // seq seen before or older: a copy if the frame is the same
+        int back = (uint8_t) (s->top - seq);
+        if (back >= DEDUP_WINDOW) {
+            return true;            // older than the window
+        }
+        uint64_t bit = 1ull << back;
+        if ((s->seen & bit) && s->sig[seq % DEDUP_WINDOW] == sig) {
+            d->duplicates++;
+            return false;
+        }
+        s->seen |= bit;             // late first copy or another frame with this seq
+    }
+    s->sig[seq % DEDUP_WINDOW] = sig;
+    return true;
+}
+
+/**
+ * count the gaps in the seq of the sources received on a link
+ * @param l
+ * @param frame
+ * @param tag session on a server link, 0 otherwise
+ * @return frames lost before this one
+ */
+int dedup_count_seq(dedup_link_t *l, const mav_frame_t *frame, uint32_t tag) {
+    uint32_t i = source_hash(frame->sysid, frame->compid, tag);
+
+    for (int n = 0; n < DEDUP_SOURCES; n++, i = (i + 1) & (DEDUP_SOURCES - 1)) {
+        dedup_seq_t *s = &l->seq[i];
+        if (!s->used) {
+            s->used = true;
+            s->sysid = frame->sysid;
+            s->compid = frame->compid;
+            s->tag = tag;
+            s->last = frame->seq;
+            return 0;
+        }
+        if (s->sysid == frame->sysid && s->compid == frame->compid && s->tag == tag) {
+            uint8_t gap = (uint8_t) (frame->seq - s->last - 1);
+            s->last = frame->seq;
+            if (gap >= 128) {
+                return 0;           // a jump back is a restart or reordering, not loss
+            }
+            l->lost += gap;
+            return gap;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,318 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   event.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "event.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+typedef struct __event_source_t {
+    int fd;
+    bool owned;                 // fd was created here (timer, signal) and is closed on remove
+    event_handler_t handler;
+    void *ctx;
+} event_source_t;
+
+static int epoll_fd = -1;
+static event_source_t sources[EVENT_MAX_SOURCES];
+
+/**
+ * create the epoll instance
+ * @return 0 if ok
+ */
+int event_init(void) {
+    for (int i = 0; i < EVENT_MAX_SOURCES; i++) {
+        sources[i].fd = -1;
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        LOG__ERROR("epoll_create1: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * switch a file descriptor to non-blocking mode
+ * @param fd
+ * @return 0 if ok
+ */
+int event_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        LOG__ERROR("fcntl O_NONBLOCK fd %d: %s", fd, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static event_source_t* find_source(int fd) {
+    for (int i = 0; i < EVENT_MAX_SOURCES; i++) {
+        if (sources[i].fd == fd) {
+            return &sources[i];
+        }
+    }
+    return NULL;
+}
+
+static int add_source(int fd, uint32_t events, event_handler_t handler, void *ctx, bool owned) {
+    event_source_t *src = find_source(-1);
+    if (!src) {
+        LOG__ERROR("too many event sources, fd %d not registered", fd);
+        return -1;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof (ev));
+    ev.events = events | EPOLLET;
+    ev.data.ptr = src;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG__ERROR("epoll_ctl add fd %d: %s", fd, strerror(errno));
+        return -1;
+    }
+
+    src->fd = fd;
+    src->owned = owned;
+    src->handler = handler;
+    src->ctx = ctx;
+    return 0;
+}
+
+/**
+ * register a file descriptor (serial port, socket, ...) as event source.
+ * The fd is switched to non-blocking mode and registered edge-triggered.
+ *
+ * @param fd
+ * @param events EPOLLIN and/or EPOLLOUT
+ * @param handler
+ * @param ctx passed to the handler
+ * @return 0 if ok
+ */
+int event_add(int fd, uint32_t events, event_handler_t handler, void *ctx) {
+    if (event_set_nonblocking(fd) < 0) {
+        return -1;
+    }
+    return add_source(fd, events, handler, ctx, false);
+}
+
+/**
+ * change the events of a registered file descriptor
+ * @param fd
+ * @param events
+ * @return 0 if ok
+ */
+int event_modify(int fd, uint32_t events) {
+    event_source_t *src = find_source(fd);
+    if (!src) return -1;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof (ev));
+    ev.events = events | EPOLLET;
+    ev.data.ptr = src;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        LOG__ERROR("epoll_ctl mod fd %d: %s", fd, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * unregister a file descriptor. Timer and signal fds are closed.
+ * @param fd
+ * @return 0 if ok
+ */
+int event_remove(int fd) {
+    event_source_t *src = find_source(fd);
+    if (!src) return -1;
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    if (src->owned) {
+        close(fd);
+    }
+    src->fd = -1;
+    src->handler = NULL;
+    return 0;
+}
+
+/**
+ * (re)arm a timer
+ * @param fd timer fd
+ * @param initial_ms first expiration, 0 disarms the timer
+ * @param interval_ms period, 0 for a one-shot timer
+ * @return 0 if ok
+ */
+int event_timer_set(int fd, int initial_ms, int interval_ms) {
+    struct itimerspec its;
+    its.it_value.tv_sec = initial_ms / 1000;
+    its.it_value.tv_nsec = (long) (initial_ms % 1000) * 1000000L;
+    its.it_interval.tv_sec = interval_ms / 1000;
+    its.it_interval.tv_nsec = (long) (interval_ms % 1000) * 1000000L;
+    if (timerfd_settime(fd, 0, &its, NULL) < 0) {
+        LOG__ERROR("timerfd_settime: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * register a periodic timer (timerfd) as event source
+ * @param interval_ms period, 0 creates a disarmed timer for event_timer_set()
+ * @param handler
+ * @param ctx
+ * @return timer fd or -1
+ */
+int event_add_timer(int interval_ms, event_handler_t handler, void *ctx) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        LOG__ERROR("timerfd_create: %s", strerror(errno));
+        return -1;
+    }
+    if (interval_ms > 0 && event_timer_set(fd, interval_ms, interval_ms) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (add_source(fd, EPOLLIN, handler, ctx, true) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * acknowledge a timer event
+ * @param fd timer fd
+ * @return number of expirations since the last read
+ */
+uint64_t event_timer_read(int fd) {
+    uint64_t expirations = 0;
+    if (read(fd, &expirations, sizeof (expirations)) != sizeof (expirations)) {
+        return 0;
+    }
+    return expirations;
+}
+
+/**
+ * block the given signals and deliver them through a signalfd
+ * @param signals
+ * @param count
+ * @param handler
+ * @param ctx
+ * @return signal fd or -1
+ */
+int event_add_signals(const int *signals, int count, event_handler_t handler, void *ctx) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int i = 0; i < count; i++) {
+        sigaddset(&mask, signals[i]);
+    }
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0) {
+        LOG__ERROR("sigprocmask: %s", strerror(errno));
+        return -1;
+    }
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        LOG__ERROR("signalfd: %s", strerror(errno));
+        return -1;
+    }
+    if (add_source(fd, EPOLLIN, handler, ctx, true) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * read the next pending signal
+ * @param fd signal fd
+ * @return signal number or -1 if no signal is pending
+ */
+int event_signal_read(int fd) {
+    struct signalfd_siginfo info;
+    if (read(fd, &info, sizeof (info)) != sizeof (info)) {
+        return -1;
+    }
+    return (int) info.ssi_signo;
+}
+
+/**
+ * dispatch events until *stop is set
+ * @param stop
+ * @return 0 if stopped, -1 on error
+ */
+int event_run(volatile sig_atomic_t *stop) {
+    struct epoll_event events[EVENT_MAX_EVENTS];
+
+    while (! *stop) {
+        int n = epoll_wait(epoll_fd, events, EVENT_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG__ERROR("epoll_wait: %s", strerror(errno));
+            return -1;
+        }
+        for (int i = 0; i < n && ! *stop; i++) {
+            event_source_t *src = events[i].data.ptr;
+            if (src->fd < 0 || !src->handler) continue; // removed in this round
+            src->handler(src->fd, events[i].events, src->ctx);
+        }
+    }
+    return 0;
+}
+
+/**
+ * close all owned event sources and the epoll instance
+ */
+void event_close(void) {
+    for (int i = 0; i < EVENT_MAX_SOURCES; i++) {
+        if (sources[i].fd >= 0) {
+            event_remove(sources[i].fd);
+        }
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+}
+
+/**
+ * monotonic clock for timeouts
+ * @return milliseconds
+ */
+uint64_t event_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
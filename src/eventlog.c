@@ -0,0 +1,365 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   eventlog.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "eventlog.h"
+#include "logging.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+/*
+ * Binary event log: fixed records in a preallocated, memory mapped file.
+ * Writing a record is a clock_gettime() and a copy, no formatting and no
+ * syscall. The file is rotated to <name>.old when it is full and cut to
+ * the used length when it is closed. mavrptevlog prints it.
+ *
+ * A helper thread keeps the next file (<name>.next) allocated and mapped,
+ * at rotation the event loop only swaps the mapping. The thread renames
+ * and closes the full file afterwards.
+ */
+
+typedef enum {
+    SEGMENT_NONE,           // helper: allocate the next file
+    SEGMENT_READY,          // next_fd/next_map can be taken by the event loop
+    SEGMENT_RETIRE          // helper: rename the full file in old_fd/old_map
+} SegmentState;
+
+bool eventlog_active = false;
+
+static char filename[256];
+static char next_name[sizeof (filename) + 8];
+static size_t file_size = 0;        // mapped bytes
+static size_t used = 0;             // header and written records
+static uint8_t *map = NULL;
+static int fd = -1;
+static uint32_t lost = 0;           // records without a file, the next one was not ready
+
+// handed between the event loop and the helper thread by segment_state
+static int segment_state = SEGMENT_NONE;
+static int next_fd = -1;
+static uint8_t *next_map = NULL;
+static int old_fd = -1;
+static uint8_t *old_map = NULL;
+
+static pthread_t thread;
+static bool thread_running = false;
+static bool thread_stop = false;
+static int wake_fd = -1;
+
+static const eventlog_info_t infos[EVENTLOG_COUNT] = {
+    [EVENTLOG_NONE]          = {"none", {NULL}},
+    [EVENTLOG_START]         = {"start", {"version"}},
+    [EVENTLOG_FRAME_RX]      = {"frame_rx", {"msgid", "sysid", "compid", "seq", "len"}},
+    [EVENTLOG_FRAME_TX]      = {"frame_tx", {"msgid", "sysid", "compid", "seq", "len"}},
+    [EVENTLOG_FRAME_DROP]    = {"frame_drop", {"msgid", "sysid", "compid", "reason"}},
+    [EVENTLOG_RADIO_STATUS]  = {"radio_status", {"txbuf", "rate"}},
+    [EVENTLOG_LINK_UP]       = {"link_up", {NULL}},
+    [EVENTLOG_LINK_DOWN]     = {"link_down", {NULL}},
+    [EVENTLOG_FEC_RECOVERED] = {"fec_recovered", {"len"}},
+};
+
+static uint64_t clock_us(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * name and argument names of an event
+ * @param event
+ * @return info, NULL if unknown
+ */
+const eventlog_info_t* eventlog_info(uint16_t event) {
+    return event < EVENTLOG_COUNT ? &infos[event] : NULL;
+}
+
+/**
+ * unmap and cut the file to the written records
+ */
+static void close_file(void) {
+    if (map) {
+        munmap(map, file_size);
+        map = NULL;
+    }
+    if (fd >= 0) {
+        if (ftruncate(fd, used) < 0) {
+            LOG__WARN("eventlog %s: truncate: %s", filename, strerror(errno));
+        }
+        close(fd);
+        fd = -1;
+    }
+}
+
+/**
+ * create, preallocate and map a file. The pages are mapped in ahead, the
+ * writer doesn't fault on them.
+ * @param name
+ * @param map_out
+ * @return fd or -1
+ */
+static int create_file(const char *name, uint8_t **map_out) {
+    int f = open(name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (f < 0) {
+        LOG__ERROR("eventlog %s: %s", name, strerror(errno));
+        return -1;
+    }
+    // the blocks are allocated now, not on the first write to a page
+    int err = posix_fallocate(f, 0, file_size);
+    if (err != 0 && ftruncate(f, file_size) < 0) {
+        LOG__ERROR("eventlog %s: allocate %zu bytes: %s", name, file_size, strerror(err));
+        close(f);
+        return -1;
+    }
+    uint8_t *m = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f, 0);
+    if (m == MAP_FAILED) {
+        LOG__ERROR("eventlog %s: mmap: %s", name, strerror(errno));
+        close(f);
+        return -1;
+    }
+    *map_out = m;
+    return f;
+}
+
+/**
+ * start a file in map with the header
+ */
+static void write_header(void) {
+    eventlog_header_t *header = (eventlog_header_t*) map;
+    memset(header, 0, sizeof (*header));
+    memcpy(header->magic, EVENTLOG_MAGIC, sizeof (header->magic));
+    header->version = EVENTLOG_VERSION;
+    header->record_size = sizeof (eventlog_record_t);
+    header->monotonic_us = clock_us(CLOCK_MONOTONIC);
+    header->realtime_us = clock_us(CLOCK_REALTIME);
+    used = sizeof (*header);
+}
+
+static void wake_helper(void) {
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof (one)) < 0) {
+        // the counter can't overflow, the helper reads it
+    }
+}
+
+/**
+ * helper: same rotation as the text log, the full file becomes <name>.old
+ * and the file the event loop writes now takes the name
+ */
+static void retire_segment(void) {
+    munmap(old_map, file_size);
+    close(old_fd);
+    old_map = NULL;
+    old_fd = -1;
+
+    char old[sizeof (filename) + 8];
+    snprintf(old, sizeof (old), "%s.old", filename);
+    if (rename(filename, old) < 0) {
+        LOG__WARN("eventlog %s: rename: %s", filename, strerror(errno));
+    }
+    if (rename(next_name, filename) < 0) {
+        LOG__WARN("eventlog %s: rename: %s", next_name, strerror(errno));
+    }
+}
+
+/**
+ * helper thread: retires the full file and allocates the next one, off the
+ * event loop
+ */
+static void* helper_thread(void *arg) {
+    struct pollfd pfd = {wake_fd, POLLIN, 0};
+    while (!__atomic_load_n(&thread_stop, __ATOMIC_ACQUIRE)) {
+        int state = __atomic_load_n(&segment_state, __ATOMIC_ACQUIRE);
+        if (state == SEGMENT_RETIRE) {
+            retire_segment();
+            state = SEGMENT_NONE;
+        }
+        if (state == SEGMENT_NONE) {
+            next_fd = create_file(next_name, &next_map);
+            state = next_fd >= 0 ? SEGMENT_READY : SEGMENT_NONE;
+            __atomic_store_n(&segment_state, state, __ATOMIC_RELEASE);
+        }
+        // without a next file (disk full) try again every EVENTLOG_RETRY_MS
+        if (poll(&pfd, 1, state == SEGMENT_READY ? -1 : EVENTLOG_RETRY_MS) > 0) {
+            uint64_t count;
+            if (read(wake_fd, &count, sizeof (count)) < 0) {
+                // nothing pending
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * event loop: continue in the file the helper has prepared. Without one
+ * the records are lost until it is there, the loop never waits for it.
+ * @return 0 if ok
+ */
+static int rotate(void) {
+    if (__atomic_load_n(&segment_state, __ATOMIC_ACQUIRE) != SEGMENT_READY) {
+        return -1;
+    }
+    old_fd = fd;
+    old_map = map;
+    fd = next_fd;
+    map = next_map;
+    next_fd = -1;
+    next_map = NULL;
+    write_header();
+    __atomic_store_n(&segment_state, SEGMENT_RETIRE, __ATOMIC_RELEASE);
+    wake_helper();
+    return 0;
+}
+
+static int start_helper(void) {
+    segment_state = SEGMENT_NONE;
+    thread_stop = false;
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        LOG__ERROR("eventlog: eventfd: %s", strerror(errno));
+        return -1;
+    }
+
+    // signals are handled by the event loop (signalfd), not by the thread
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&thread, NULL, helper_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        LOG__ERROR("eventlog: create thread failed: %s", strerror(err));
+        close(wake_fd);
+        wake_fd = -1;
+        return -1;
+    }
+    thread_running = true;
+    return 0;
+}
+
+/**
+ * stop the helper, finish a pending rotation and drop the prepared file
+ */
+static void stop_helper(void) {
+    if (!thread_running) return;
+    __atomic_store_n(&thread_stop, true, __ATOMIC_RELEASE);
+    wake_helper();
+    pthread_join(thread, NULL);
+    thread_running = false;
+    close(wake_fd);
+    wake_fd = -1;
+
+    if (segment_state == SEGMENT_RETIRE) {
+        retire_segment();
+    } else if (segment_state == SEGMENT_READY) {
+        munmap(next_map, file_size);
+        close(next_fd);
+        unlink(next_name);
+        next_map = NULL;
+        next_fd = -1;
+    }
+    segment_state = SEGMENT_NONE;
+}
+
+/**
+ * open the event log
+ * @param name file
+ * @param max_size bytes per file, rotated when full
+ * @return 0 if ok
+ */
+int eventlog_open(const char *name, size_t max_size) {
+    eventlog_close();
+
+    strncpy(filename, name, sizeof (filename) - 1);
+    snprintf(next_name, sizeof (next_name), "%s.next", filename);
+    if (max_size == 0) {
+        max_size = EVENTLOG_DEFAULT_SIZE;
+    }
+    size_t records = (max_size - sizeof (eventlog_header_t)) / sizeof (eventlog_record_t);
+    if (max_size <= sizeof (eventlog_header_t) || records == 0) {
+        LOG__ERROR("eventlog %s: size %zu too small", filename, max_size);
+        return -1;
+    }
+    file_size = sizeof (eventlog_header_t) + records * sizeof (eventlog_record_t);
+    fd = create_file(filename, &map);
+    if (fd < 0) {
+        return -1;
+    }
+    write_header();
+    lost = 0;
+    if (start_helper() < 0) {
+        close_file();
+        return -1;
+    }
+    eventlog_active = true;
+    LOG__INFO("eventlog %s: %zu records per file", filename, records);
+
+    EVENTLOG(EVENTLOG_START, EVENTLOG_NO_LINK, EVENTLOG_VERSION);
+    return 0;
+}
+
+void eventlog_close(void) {
+    eventlog_active = false;
+    stop_helper();
+    close_file();
+    if (lost > 0) {
+        LOG__WARN("eventlog %s: %u records lost, the next file was not ready", filename, lost);
+        lost = 0;
+    }
+}
+
+/**
+ * append a record, use EVENTLOG()
+ * @param event
+ * @param link
+ * @param args
+ * @param argc more than EVENTLOG_ARGS are cut
+ */
+void eventlog_write(uint16_t event, uint8_t link, const uint32_t *args, int argc) {
+    if (used + sizeof (eventlog_record_t) > file_size && rotate() < 0) {
+        lost++;
+        return;
+    }
+
+    eventlog_record_t *rec = (eventlog_record_t*) (map + used);
+    if (argc > EVENTLOG_ARGS) argc = EVENTLOG_ARGS;
+    rec->time_us = clock_us(CLOCK_MONOTONIC);
+    rec->event = event;
+    rec->link = link;
+    rec->argc = argc;
+    memcpy(rec->arg, args, argc * sizeof (uint32_t));
+    memset(rec->arg + argc, 0, (EVENTLOG_ARGS - argc) * sizeof (uint32_t));
+    used += sizeof (eventlog_record_t);
+}
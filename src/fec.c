@@ -0,0 +1,223 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   fec.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "fec.h"
+#include <string.h>
+
+/*
+ * A data datagram gets a header (magic, group, index). After k datagrams,
+ * or when the window has passed, the parity of the group follows:
+ *
+ *   magic, group, 0x80 | count, xor of the lengths, xor of the datagrams
+ *
+ * The receiver forwards every datagram at once and keeps the xor of the
+ * group. If exactly one datagram is missing when the parity arrives, the
+ * xor is that datagram. Only the rebuilt datagram waits for the parity, at
+ * most the window on the sender plus the transit time.
+ */
+
+static inline void xor_into(uint8_t *acc, const uint8_t *data, int len) {
+    for (int i = 0; i < len; i++) {
+        acc[i] ^= data[i];
+    }
+}
+
+/**
+ * @param f
+ * @param k data datagrams per parity (overhead 1/k), 0 = only decode
+ * @param window_ms max. time of a group, 0 = FEC_WINDOW_MS
+ * @param stats counters, shared by the peers of a link
+ */
+void fec_init(fec_t *f, int k, int window_ms, fec_stats_t *stats) {
+    memset(f, 0, sizeof (*f));
+    if (k > FEC_MAX_GROUP) k = FEC_MAX_GROUP;
+    f->k = (k >= 2) ? k : 0;
+    f->window_ms = (window_ms > 0) ? window_ms : FEC_WINDOW_MS;
+    f->stats = stats;
+}
+
+/**
+ * add a datagram to the group being sent
+ * @param f
+ * @param slot datagram number in the send batch, selects the header buffer
+ * @param iov pieces of the datagram, at most FEC_MAX_DATA bytes
+ * @param iovlen
+ * @param now
+ * @return header to put in front of the datagram
+ */
+const uint8_t* fec_encode(fec_t *f, int slot, const struct iovec *iov, int iovlen, uint64_t now) {
+    uint8_t *header = f->header[slot];
+    uint8_t *acc = f->acc + FEC_PARITY_HEADER;
+    int len = 0;
+
+    for (int i = 0; i < iovlen; i++) {
+        int n = (int) iov[i].iov_len;
+        if (len + n > FEC_MAX_DATA) n = FEC_MAX_DATA - len;
+        xor_into(acc + len, iov[i].iov_base, n);
+        len += n;
+    }
+    if (f->count == 0) {
+        f->first_ms = now;
+    }
+    header[0] = FEC_MAGIC;
+    header[1] = f->group;
+    header[2] = f->count++;
+    f->len_xor ^= (uint16_t) len;
+    if (len > f->len) f->len = len;
+    return header;
+}
+
+bool fec_group_full(const fec_t *f) {
+    return f->count >= f->k;
+}
+
+bool fec_group_open(const fec_t *f) {
+    return f->count > 0;
+}
+
+/**
+ * close the group being sent
+ * @param f
+ * @param out buffer of UDP_DATAGRAM_SIZE bytes for the parity datagram
+ * @return length of the parity datagram, 0 if the group is empty
+ */
+int fec_parity(fec_t *f, uint8_t *out) {
+    if (f->count == 0) {
+        return 0;
+    }
+    int len = FEC_PARITY_HEADER + f->len;
+    f->acc[0] = FEC_MAGIC;
+    f->acc[1] = f->group;
+    f->acc[2] = FEC_PARITY | f->count;
+    f->acc[3] = (uint8_t) (f->len_xor & 0xFF);
+    f->acc[4] = (uint8_t) (f->len_xor >> 8);
+    memcpy(out, f->acc, len);
+
+    memset(f->acc + FEC_PARITY_HEADER, 0, f->len);
+    f->group++;
+    f->count = 0;
+    f->len = 0;
+    f->len_xor = 0;
+    f->stats->groups++;
+    f->stats->parity_bytes += len;
+    return len;
+}
+
+static fec_group_t* rx_group(fec_t *f, uint8_t group, uint64_t now) {
+    fec_group_t *r = &f->rx[group % FEC_RX_GROUPS];
+    if (r->valid && r->group == group) {
+        return r;
+    }
+    if (r->valid && r->parity && !r->done) {
+        f->stats->unrecoverable++;
+    }
+    memset(r->acc, 0, r->len);
+    r->valid = true;
+    r->parity = false;
+    r->done = false;
+    r->group = group;
+    r->count = 0;
+    r->len_xor = 0;
+    r->received = 0;
+    r->len = 0;
+    r->first_ms = now;
+    return r;
+}
+
+static inline void rx_add(fec_group_t *r, const uint8_t *data, int len) {
+    xor_into(r->acc, data, len);
+    if (len > r->len) r->len = len;
+}
+
+/**
+ * take a FEC datagram apart
+ * @param f
+ * @param data
+ * @param len
+ * @param now
+ * @param payload the datagram without FEC header
+ * @param recovered a lost datagram of the group, valid until the next call
+ * @param recovered_len 0 if none
+ * @return length of payload, 0 for a parity or a duplicate
+ */
+int fec_receive(fec_t *f, const uint8_t *data, int len, uint64_t now,
+        const uint8_t **payload, const uint8_t **recovered, int *recovered_len) {
+    fec_group_t *r = rx_group(f, data[1], now);
+    int plen = 0;
+
+    *recovered_len = 0;
+    f->seen = true;
+    if (data[2] & FEC_PARITY) {
+        f->stats->rx_parity++;
+        if (len < FEC_PARITY_HEADER || r->parity) {
+            return 0;
+        }
+        r->parity = true;
+        r->count = data[2] & ~FEC_PARITY;
+        r->len_xor ^= (uint16_t) (data[3] | (data[4] << 8));
+        rx_add(r, data + FEC_PARITY_HEADER, len - FEC_PARITY_HEADER);
+    } else {
+        uint32_t bit = 1u << (data[2] % FEC_MAX_GROUP);
+        if (r->received & bit) {
+            f->stats->duplicates++;
+            return 0;
+        }
+        r->received |= bit;
+        plen = len - FEC_HEADER_LEN;
+        *payload = data + FEC_HEADER_LEN;
+        if (!r->done) {
+            r->len_xor ^= (uint16_t) plen;
+            rx_add(r, *payload, plen);
+        }
+    }
+
+    if (r->parity && !r->done) {
+        int have = __builtin_popcount(r->received);
+        if (have + 1 == r->count) {
+            r->done = true;
+            if (now - r->first_ms > 2 * (uint64_t) f->window_ms) {
+                f->stats->late++;
+            } else if (r->len_xor > 0 && r->len_xor <= r->len) {
+                // the missing one counts as received, a late copy is a duplicate
+                for (int i = 0; i < r->count; i++) {
+                    if (!(r->received & (1u << i))) {
+                        r->received |= 1u << i;
+                        break;
+                    }
+                }
+                *recovered = r->acc;
+                *recovered_len = r->len_xor;
+                f->stats->recovered++;
+            }
+        } else if (have >= r->count) {
+            r->done = true;
+        }
+    }
+    return plen;
+}
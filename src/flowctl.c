@@ -0,0 +1,117 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   flowctl.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "flowctl.h"
+#include "logging.h"
+#include "common/mavlink.h"
+
+#define RADIO_STATUS_TXBUF_OFS 6        // rxerrors, fixed, rssi, remrssi, txbuf, ...
+
+void flowctl_init(flowctl_t *flow) {
+    flow->percent = 100;
+    flow->txbuf = -1;
+    flow->last_ms = 0;
+    flow->credit = 0;
+    flow->status_count = 0;
+    flow->throttled = 0;
+    flow->downsampled = 0;
+}
+
+/**
+ * adapt the rate to a RADIO_STATUS of the radio: decrease fast while the
+ * buffer fills, increase slowly when it is drained
+ * @param flow
+ * @param frame RADIO_STATUS received on the link
+ * @param now ms
+ * @return true if the allowed rate changed
+ */
+bool flowctl_radio_status(flowctl_t *flow, const mav_frame_t *frame, uint64_t now) {
+    // the trailing zeros of a v2 payload may be truncated
+    int txbuf = (frame->payload_len > RADIO_STATUS_TXBUF_OFS) ? frame->payload[RADIO_STATUS_TXBUF_OFS] : 0;
+    int percent = flow->percent;
+
+    flow->txbuf = txbuf;
+    flow->last_ms = now;
+    flow->status_count++;
+
+    if (txbuf < FLOWCTL_TXBUF_CRITICAL) {
+        percent /= 2;
+    } else if (txbuf < FLOWCTL_TXBUF_LOW) {
+        percent = percent * 9 / 10;
+    } else if (txbuf > FLOWCTL_TXBUF_HIGH) {
+        percent += FLOWCTL_STEP;
+    }
+    if (percent < FLOWCTL_MIN_PERCENT) percent = FLOWCTL_MIN_PERCENT;
+    if (percent > 100) percent = 100;
+
+    if (percent == flow->percent) {
+        return false;
+    }
+    if (percent < flow->percent) {
+        flow->throttled++;
+    }
+    LOG__DEBUG("radio txbuf %d%%, rate %d%%", txbuf, percent);
+    flow->percent = percent;
+    return true;
+}
+
+/**
+ * without RADIO_STATUS (no SiK radio or lost) the full rate is restored
+ * @param flow
+ * @param now ms
+ * @return true if the allowed rate changed
+ */
+bool flowctl_expire(flowctl_t *flow, uint64_t now) {
+    if (flow->percent == 100 || now - flow->last_ms < FLOWCTL_TIMEOUT_MS) {
+        return false;
+    }
+    LOG__INFO("no radio status for %d ms, full rate", FLOWCTL_TIMEOUT_MS);
+    flow->percent = 100;
+    flow->txbuf = -1;
+    return true;
+}
+
+/**
+ * downsample non-critical frames in proportion to the allowed rate,
+ * e.g. every second frame passes at 50%
+ * @param flow
+ * @return true if the frame is to be dropped
+ */
+bool flowctl_downsample(flowctl_t *flow) {
+    if (flow->percent >= 100) {
+        return false;
+    }
+    flow->credit += flow->percent;
+    if (flow->credit >= 100) {
+        flow->credit -= 100;
+        return false;
+    }
+    flow->downsampled++;
+    return true;
+}
@@ -0,0 +1,134 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   framebuf.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "framebuf.h"
+#include "logging.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * buffers allocated together, by framebuf_init() or framebuf_reserve()
+ */
+typedef struct __framebuf_chunk_t {
+    struct __framebuf_chunk_t *next;
+    framebuf_t buffers[];
+} framebuf_chunk_t;
+
+static framebuf_chunk_t *chunks = NULL;
+static framebuf_t *free_list = NULL;
+static framebuf_stats_t stats;
+
+/**
+ * add count buffers to the pool
+ * @param count
+ * @return 0 if ok
+ */
+int framebuf_reserve(int count) {
+    framebuf_chunk_t *chunk = calloc(1, sizeof (framebuf_chunk_t) + count * sizeof (framebuf_t));
+    if (!chunk) {
+        LOG__ERROR("allocate %d frame buffers failed", count);
+        return -1;
+    }
+    chunk->next = chunks;
+    chunks = chunk;
+    for (int i = count - 1; i >= 0; i--) {
+        chunk->buffers[i].next = free_list;
+        free_list = &chunk->buffers[i];
+    }
+    stats.size += count;
+    return 0;
+}
+
+/**
+ * allocate the shared part of the pool. Links which queue frames add their
+ * queue capacity with framebuf_reserve() when they are set up, there is no
+ * allocation on the forwarding path.
+ * @return 0 if ok
+ */
+int framebuf_init(void) {
+    framebuf_close();
+    memset(&stats, 0, sizeof (stats));
+    return framebuf_reserve(FRAMEBUF_POOL_SIZE);
+}
+
+/**
+ * copy a frame into a buffer of the pool
+ * @param frame
+ * @return buffer with refcount 1, NULL if the pool is exhausted
+ */
+framebuf_t* framebuf_get(const mav_frame_t *frame) {
+    framebuf_t *fb = free_list;
+    if (!fb) {
+        stats.exhausted++;
+        return NULL;
+    }
+    free_list = fb->next;
+
+    fb->refcount = 1;
+    memcpy(fb->data, frame->data, frame->len);
+    fb->frame = *frame;
+    fb->frame.data = fb->data;
+    fb->frame.payload = fb->data + (frame->payload - frame->data);
+
+    if (++stats.in_use > stats.in_use_max) {
+        stats.in_use_max = stats.in_use;
+    }
+    return fb;
+}
+
+framebuf_t* framebuf_ref(framebuf_t *fb) {
+    fb->refcount++;
+    return fb;
+}
+
+/**
+ * release a reference, the last one returns the buffer to the pool
+ * @param fb
+ */
+void framebuf_unref(framebuf_t *fb) {
+    if (--fb->refcount > 0) {
+        return;
+    }
+    fb->next = free_list;
+    free_list = fb;
+    stats.in_use--;
+}
+
+const framebuf_stats_t* framebuf_stats(void) {
+    return &stats;
+}
+
+void framebuf_close(void) {
+    while (chunks) {
+        framebuf_chunk_t *next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+    free_list = NULL;
+}
@@ -0,0 +1,248 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   framer.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "framer.h"
+#include "common/mavlink.h"
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * initialize a framer
+ * @param framer
+ */
+void framer_init(framer_t *framer) {
+    framer->data = framer->buffer;
+    framer->len = 0;
+    framer->pos = 0;
+    memset(&framer->stats, 0, sizeof (framer->stats));
+}
+
+/**
+ * parse a complete datagram in place, without copying it into the framer
+ * buffer. Buffered bytes of a stream are discarded, a frame never spans
+ * two datagrams.
+ *
+ * @param framer
+ * @param data must stay valid as long as the frames are used
+ * @param len
+ */
+void framer_attach(framer_t *framer, const uint8_t *data, int len) {
+    framer->data = data;
+    framer->len = len;
+    framer->pos = 0;
+}
+
+/**
+ * returns the write position for the next read into the framer buffer.
+ * Already parsed bytes are discarded first, so all frames returned by
+ * framer_next() before are invalid afterwards.
+ *
+ * @param framer
+ * @param space free bytes at the write position
+ * @return write pointer
+ */
+uint8_t* framer_write_ptr(framer_t *framer, int *space) {
+    if (framer->data != framer->buffer) {
+        framer->data = framer->buffer;
+        framer->len = 0;
+        framer->pos = 0;
+    }
+    if (framer->pos > 0) {
+        int rest = framer->len - framer->pos;
+        if (rest > 0) {
+            memmove(framer->buffer, framer->buffer + framer->pos, rest);
+        }
+        framer->len = rest;
+        framer->pos = 0;
+    }
+    *space = FRAMER_BUFFER_SIZE - framer->len;
+    return framer->buffer + framer->len;
+}
+
+/**
+ * mark len bytes at the write position as received
+ * @param framer
+ * @param len
+ */
+void framer_commit(framer_t *framer, int len) {
+    if (len > 0) {
+        framer->len += len;
+    }
+}
+
+/**
+ * returns the message entry (crc extra, length, target offsets) of msgid
+ * @param msgid
+ * @return entry or NULL if msgid is unknown
+ */
+const mavlink_msg_entry_t* framer_msg_entry(uint32_t msgid) {
+    return mavlink_get_msg_entry(msgid);
+}
+
+/**
+ * msgid of a message name (e.g. "ATTITUDE") or a number as string
+ * @param name
+ * @param msgid
+ * @return true if found
+ */
+bool framer_msgid_from_name(const char *name, uint32_t *msgid) {
+    char *end;
+    unsigned long id = strtoul(name, &end, 10);
+    if (end != name && *end == '\0') {
+        *msgid = (uint32_t) id;
+        return true;
+    }
+
+#ifdef MAVLINK_MESSAGE_NAMES
+    // sorted by name
+    static const struct {
+        const char *name;
+        uint32_t msgid;
+    } names[] = MAVLINK_MESSAGE_NAMES;
+    int low = 0, high = sizeof (names) / sizeof (names[0]) - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        int cmp = strcmp(name, names[mid].name);
+        if (cmp == 0) {
+            *msgid = names[mid].msgid;
+            return true;
+        }
+        if (cmp < 0) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+#endif
+    return false;
+}
+
+/**
+ * search the next complete frame in the buffer. The frame is not copied,
+ * frame->data points directly into the framer buffer.
+ *
+ * @param framer
+ * @param frame
+ * @return true if a complete frame was found
+ */
+bool framer_next(framer_t *framer, mav_frame_t *frame) {
+    while (framer->pos < framer->len) {
+        const uint8_t *p = framer->data + framer->pos;
+        int avail = framer->len - framer->pos;
+
+        if (p[0] != MAVLINK_STX && p[0] != MAVLINK_STX_MAVLINK1) {
+            framer->pos++;
+            framer->stats.skipped_bytes++;
+            continue;
+        }
+
+        int header_len;
+        int total;
+        if (p[0] == MAVLINK_STX) {
+            header_len = MAVLINK_V2_HEADER_LEN;
+            if (avail < header_len) return false;
+            if (p[2] & ~MAVLINK_IFLAG_SIGNED) {
+                // unknown incompat flag, can't be a valid frame
+                framer->pos++;
+                framer->stats.skipped_bytes++;
+                continue;
+            }
+            total = header_len + p[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+            if (p[2] & MAVLINK_IFLAG_SIGNED) {
+                total += MAVLINK_SIGNATURE_BLOCK_LEN;
+            }
+        } else {
+            header_len = MAVLINK_V1_HEADER_LEN;
+            if (avail < header_len) return false;
+            total = header_len + p[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+        }
+
+        if (avail < total) return false;
+
+        uint32_t msgid;
+        if (p[0] == MAVLINK_STX) {
+            msgid = p[7] | (p[8] << 8) | ((uint32_t) p[9] << 16);
+        } else {
+            msgid = p[5];
+        }
+
+        const mavlink_msg_entry_t *entry = mavlink_get_msg_entry(msgid);
+        if (entry) {
+            // checksum over header (without STX) and payload, followed by crc extra
+            uint16_t crc = crc_calculate(p + 1, header_len - 1 + p[1]);
+            crc_accumulate(entry->crc_extra, &crc);
+            const uint8_t *ck = p + header_len + p[1];
+            if ((crc & 0xFF) != ck[0] || (crc >> 8) != ck[1]) {
+                framer->pos++;
+                framer->stats.bad_crc++;
+                framer->stats.skipped_bytes++;
+                continue;
+            }
+        } else {
+            // can't check the crc without crc extra. Forward it anyway, but only
+            // if the next frame starts directly behind it, otherwise a wrong STX
+            // inside the payload could swallow the following frames. On a stream
+            // wait for the next byte, only the end of a datagram is a boundary.
+            if (avail == total && framer->data == framer->buffer) {
+                return false;
+            }
+            if (avail > total && p[total] != MAVLINK_STX && p[total] != MAVLINK_STX_MAVLINK1) {
+                framer->pos++;
+                framer->stats.skipped_bytes++;
+                continue;
+            }
+            framer->stats.unknown_msgid++;
+        }
+
+        frame->data = p;
+        frame->len = total;
+        frame->payload = p + header_len;
+        frame->payload_len = p[1];
+        frame->msgid = msgid;
+        frame->entry = entry;
+        if (p[0] == MAVLINK_STX) {
+            frame->version = 2;
+            frame->incompat_flags = p[2];
+            frame->seq = p[4];
+            frame->sysid = p[5];
+            frame->compid = p[6];
+        } else {
+            frame->version = 1;
+            frame->incompat_flags = 0;
+            frame->seq = p[2];
+            frame->sysid = p[3];
+            frame->compid = p[4];
+        }
+
+        framer->pos += total;
+        framer->stats.frames++;
+        return true;
+    }
+    return false;
+}
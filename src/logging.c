@@ -36,14 +36,49 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <stdbool.h>
-#include <ctype.h>
+#include <stdint.h>
+#include <strings.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 
-static LogLevel current_level = LOGLEVEL_INFO;
+/*
+ * log_msg() only formats the text into a slot of a lock-free ring. The
+ * logging thread adds the time stamp, writes, rotates and flushes, so the
+ * forwarding threads never wait for the log file. Before log_start() and
+ * after log_close() the records are written directly.
+ */
+
+/**
+ * one message in the ring. seq tells who may use the slot next:
+ * pos = free for the writer of pos, pos + 1 = filled for the reader.
+ */
+typedef struct __log_record_t {
+    uint32_t seq;
+    uint8_t level;
+    time_t time;
+    char text[LOG_RECORD_TEXT];
+} __attribute__((aligned(64))) log_record_t;
+
+LogLevel log_current_level = LOGLEVEL_INFO;
 static FILE *log_file = NULL;
 static char log_filename[256] = LOGFILE_DEFAULT_NAME;
 static size_t max_log_size = LOGFILE_DEFAULT_SIZE_MAX;
+static size_t log_size = 0;         // bytes in the log file, no stat() per message
 static bool log_to_stdout = false;
 
+static log_record_t ring[LOG_RING_SIZE];
+static uint32_t ring_head = 0;      // next slot of the writers (log_msg)
+static uint32_t ring_tail = 0;      // next slot of the logging thread
+static uint32_t dropped = 0;        // messages lost at the full ring
+static uint32_t dropped_reported = 0;
+static pthread_t thread;
+static bool thread_running = false;
+static bool thread_stop = false;
+static int wake_fd = -1;
+
 const char* loglevel_strings[] = {
     "TRACE",
     "DEBUG",
@@ -64,9 +99,14 @@ void logSTD() {
  * @param level
  */
 void log_set_level(LogLevel level) {
-    current_level = level;
+    log_current_level = level;
 }
 
+/**
+ * log into a file, call before log_start()
+ * @param filename
+ * @param max_size_bytes the file is renamed to .old at this size
+ */
 void log_set_file(const char *filename, size_t max_size_bytes) {
     strncpy(log_filename, filename, sizeof (log_filename) - 1);
     max_log_size = max_size_bytes;
@@ -74,14 +114,10 @@ void log_set_file(const char *filename, size_t max_size_bytes) {
     if (!log_file) {
         perror("log file open");
         log_file = stderr; // Fallback
+        return;
     }
-}
-
-void log_close() {
-    if (log_file && log_file != stderr) {
-        fclose(log_file);
-        log_file = NULL;
-    }
+    struct stat st;
+    log_size = fstat(fileno(log_file), &st) == 0 ? st.st_size : 0;
 }
 
 /**
@@ -102,14 +138,8 @@ const char* loglevel_to_string(LogLevel level) {
  * @return LogLevel
  */
 const LogLevel loglevel_from_string(const char* string) {
-    char *str = strdup(string);
-    char *s = str;
-    while (*s) {
-        *s = toupper((unsigned char) *s);
-        s++;
-    }
     for (int i = 0; i < LOGLEVEL_COUNT; i++) {
-        if (strcmp(str, loglevel_strings[i]) == 0) {
+        if (strcasecmp(string, loglevel_strings[i]) == 0) {
             return (LogLevel) i;
         }
     }
@@ -168,8 +198,7 @@ static void split_path_components(const char* fullpath, char* out_dir, size_t di
 static void check_logfile_size_and_rotate() {
     if (!log_file || log_file == stderr) return;
 
-    struct stat st;
-    if (stat(log_filename, &st) == 0 && st.st_size >= max_log_size) {
+    if (log_size >= max_log_size) {
         fclose(log_file);
 
         char dir[256], base[256], ext[64];
@@ -180,37 +209,200 @@ static void check_logfile_size_and_rotate() {
 
         rename(log_filename, old_logfile);
         log_file = fopen(log_filename, "w"); // neue Datei
+        log_size = 0;
     }
 }
 
-void log_msg(LogLevel level, const char *fmt, ...) {
-    if (level < current_level) return;
-check_logfile_size_and_rotate();
-    FILE *out;
+/**
+ * write one message with time stamp and level, runs in the logging thread
+ * (or directly while it is not running). Not flushed.
+ */
+static void write_record(LogLevel level, time_t stamp, const char *text) {
     if (!log_to_stdout) {
         check_logfile_size_and_rotate();
 
-        time_t now = time(NULL);
-        struct tm *t = localtime(&now);
-        char timebuf[20];
-        strftime(timebuf, sizeof (timebuf), "%Y-%m-%d %H:%M:%S", t);
-
-        out = log_file ? log_file : stderr;
-        fprintf(out, "[%s] %-5s: ", timebuf, loglevel_to_string(level));
+        // the time stamp changes once per second
+        static time_t last = -1;
+        static char timebuf[20];
+        if (stamp != last) {
+            struct tm t;
+            localtime_r(&stamp, &t);
+            strftime(timebuf, sizeof (timebuf), "%Y-%m-%d %H:%M:%S", &t);
+            last = stamp;
+        }
 
+        FILE *out = log_file ? log_file : stderr;
+        int n = fprintf(out, "[%s] %-5s: %s\n", timebuf, loglevel_to_string(level), text);
+        if (n > 0) log_size += n;
     } else {
-//printf("log->std|");
-        out = stderr;
-        fprintf(out, "%s [%-5s]: ", progname, loglevel_to_string(level));
+        fprintf(stderr, "%s [%-5s]: %s\n", progname, loglevel_to_string(level), text);
     }
+}
 
+static void flush_output(void) {
+    fflush(log_to_stdout || !log_file ? stderr : log_file);
+}
+
+/**
+ * write all filled slots of the ring and report lost messages
+ * @return number of messages written
+ */
+static int drain_ring(void) {
+    int count = 0;
+    for (;;) {
+        log_record_t *rec = &ring[ring_tail & (LOG_RING_SIZE - 1)];
+        if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != ring_tail + 1) {
+            break;
+        }
+        write_record((LogLevel) rec->level, rec->time, rec->text);
+        __atomic_store_n(&rec->seq, ring_tail + LOG_RING_SIZE, __ATOMIC_RELEASE);
+        ring_tail++;
+        count++;
+    }
+
+    uint32_t lost = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+    if (lost != dropped_reported) {
+        char text[64];
+        snprintf(text, sizeof (text), "logging: %u messages dropped, ring full", lost - dropped_reported);
+        write_record(LOGLEVEL_WARN, time(NULL), text);
+        dropped_reported = lost;
+        count++;
+    }
+    return count;
+}
+
+static void* log_thread(void *arg) {
+    struct pollfd pfd = {wake_fd, POLLIN, 0};
+    while (!__atomic_load_n(&thread_stop, __ATOMIC_ACQUIRE)) {
+        if (drain_ring() > 0) {
+            flush_output();
+        }
+        if (poll(&pfd, 1, LOG_FLUSH_MS) > 0) {
+            uint64_t count;
+            if (read(wake_fd, &count, sizeof (count)) < 0) {
+                // nothing pending
+            }
+        }
+    }
+    drain_ring();
+    flush_output();
+    return NULL;
+}
+
+static void wake_thread(void) {
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof (one)) < 0) {
+        // the thread reads the counter, it can't overflow
+    }
+}
+
+/**
+ * start the logging thread. Call after fork(), threads don't survive it.
+ * @return 0 if ok, otherwise messages are still written directly
+ */
+int log_start(void) {
+    if (thread_running) return 0;
+
+    for (uint32_t i = 0; i < LOG_RING_SIZE; i++) {
+        ring[i].seq = i;
+    }
+    ring_head = ring_tail = 0;
+    thread_stop = false;
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        fprintf(stderr, "%s: logging eventfd: %s\n", progname, strerror(errno));
+        return -1;
+    }
+
+    // signals are handled by the event loop (signalfd), not by the thread
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&thread, NULL, log_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        fprintf(stderr, "%s: create logging thread failed: %s\n", progname, strerror(err));
+        close(wake_fd);
+        wake_fd = -1;
+        return -1;
+    }
+    __atomic_store_n(&thread_running, true, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * stop the logging thread after it has written the ring, close the log file.
+ * The other threads must not log any more.
+ */
+void log_close() {
+    if (thread_running) {
+        __atomic_store_n(&thread_running, false, __ATOMIC_RELEASE);
+        __atomic_store_n(&thread_stop, true, __ATOMIC_RELEASE);
+        wake_thread();
+        pthread_join(thread, NULL);
+        close(wake_fd);
+        wake_fd = -1;
+    }
+    if (log_file && log_file != stderr) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+}
+
+/**
+ * @return messages lost because the ring was full
+ */
+uint32_t log_dropped(void) {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+/**
+ * log a message. With the logging thread running this only formats the
+ * text into the ring, never blocks and never allocates. Messages which
+ * don't fit are counted and reported by the thread.
+ */
+void log_msg(LogLevel level, const char *fmt, ...) {
+    if (level < log_current_level) return;
 
     va_list args;
+    if (!__atomic_load_n(&thread_running, __ATOMIC_ACQUIRE)) {
+        char text[LOG_RECORD_TEXT];
+        va_start(args, fmt);
+        vsnprintf(text, sizeof (text), fmt, args);
+        va_end(args);
+        write_record(level, time(NULL), text);
+        flush_output();
+        return;
+    }
+
+    // claim a slot, several threads may log at the same time
+    uint32_t pos = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+    log_record_t *rec;
+    for (;;) {
+        rec = &ring[pos & (LOG_RING_SIZE - 1)];
+        int32_t diff = (int32_t) (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring_head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    rec->level = level;
+    rec->time = time(NULL);
     va_start(args, fmt);
-    vfprintf(out, fmt, args);
+    vsnprintf(rec->text, sizeof (rec->text), fmt, args);
     va_end(args);
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
 
-    fprintf(out, "\n");
-    fflush(out);
+    // the thread polls every LOG_FLUSH_MS, wake it early for errors and
+    // before the ring runs full
+    if (level >= LOGLEVEL_WARN || (pos & (LOG_RING_SIZE / 4 - 1)) == 0) {
+        wake_thread();
+    }
 }
-
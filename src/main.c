@@ -36,14 +36,17 @@
 #include <syslog.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <sys/select.h>
 #include <signal.h>
 
-#include "serial.h"
-#include "udp.h"
 #include "option.h"
 #include "common/mavlink.h"
 #include "logging.h"
+#include "event.h"
+#include "relay.h"
+#include "resolver.h"
+#include "eventlog.h"
+#include "recorder.h"
+#include "replay.h"
 
 #define JSON_CONFIG_FILE "/etc/mavlink-repeater.json"
 #define PID_FILE "/tmp/mavrpts.pid"
@@ -87,9 +90,14 @@ void initialize() {
     prognames.mav_repeater = "mavrpt";    // MAVLink repeater forwards directly from the air station to the ground station
     prognames.mav_repeater_client = "mavrptclient";    // MAVLink repeater Client routes the data from the Air Station through the existing IP tunnel to the Ground Station server
     prognames.mav_repeater_server = "mavrptserver";    // MAVLink repeater Server handles the connection from the IP tunnel of the air station/clients and establishes a connection to a ground station software
+    prognames.mav_repeater_replay = "replay";    // feeds a recorded tlog through the relay in place of the serial port, for load tests (--function replay)
 
     strncpy(options.device_dflt, SERIAL_DEVICE, sizeof options.device_dflt);
     options.baudrate_dflt = SERIAL_DEVICE_BAUDRATE;
+    strncpy(options.server, UDP_IP, sizeof options.server - 1);
+    options.port = UDP_PORT;
+    options.tlog_minutes = RECORDER_DEFAULT_MINUTES;
+    options.replay_speed = 1.0;
 }
 
 
@@ -104,6 +112,25 @@ void signal_handler(int signal) {
     }
 }
 
+/**
+ * signals are delivered through a signalfd in the event loop
+ */
+static void on_signal_event(int fd, uint32_t events, void *ctx) {
+    int signo;
+    while ((signo = event_signal_read(fd)) > 0) {
+        signal_handler(signo);
+    }
+}
+
+/**
+ * the tlog and event log files are preallocated, cut them to the used
+ * length also when main() returns with an error
+ */
+static void close_recording(void) {
+    recorder_close();
+    eventlog_close();
+}
+
 int main(int argc, char *argv[]) {
 
     signal(SIGINT, signal_handler);
@@ -119,6 +146,15 @@ int main(int argc, char *argv[]) {
         printf("  device   : %s\n", options.device);
         printf("  baudrate : %d\n", options.baudrate);
         printf("  server   : %s\n", options.server);
+        printf("  port     : %d\n", options.port);
+        for (int i = 0; i < options.endpoint_count; i++) {
+            endpoint_opt_t *ep = &options.endpoints[i];
+            if (ep->type == ENDPOINT_SERIAL) {
+                printf("  endpoint : serial %s %d\n", ep->device, ep->baudrate);
+            } else {
+                printf("  endpoint : %s %s:%d\n", ep->type == ENDPOINT_TCP ? "tcp" : "udp", ep->server, ep->port);
+            }
+        }
         printf("  loglevel : %s\n", options.loglevel);
         printf("  daemon   : %d\n", options.daemon);
         printf("  logfile  : %s\n", options.logfile);
@@ -198,167 +234,102 @@ int main(int argc, char *argv[]) {
 
     if (options.daemon) sleep(10);
 
-    int serial_fd = openSerial(options.device, options.baudrate);
-    if (serial_fd < 0) {
-        perror("Serial open failed");
-        return 1;
+    // from here on the log file is written by the logging thread. Every exit
+    // flushes the ring, also the error returns below
+    log_start();
+    atexit(log_close);
+    if (strlen(options.eventlog) > 0) {
+        eventlog_open(options.eventlog, options.eventlogsize);
     }
+    if (strlen(options.tlog) > 0) {
+        recorder_open(options.tlog, options.tlog_size, options.tlog_minutes);
+    }
+    atexit(close_recording);
 
-    int udp_fd = setup_udp_client_socket(UDP_IP, UDP_PORT);
-    if (udp_fd < 0) {
-        perror("UDP socket failed");
+    if (event_init() < 0 || resolver_init() < 0 || relay_init() < 0) {
         return 1;
     }
+    relay_set_dedup(options.dedup);
 
-    write_pidfile(PID_FILE);
-    uint8_t buffer[1024];
-    mavlink_message_t msg;
-    mavlink_status_t status;
-
-    while (! stop_requested) {
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(serial_fd, &readfds);
-        FD_SET(udp_fd, &readfds);
-
-        int maxfd = (serial_fd > udp_fd) ? serial_fd : udp_fd;
-        struct timeval timeout = {1, 0};
-
-        int result = select(maxfd + 1, &readfds, NULL, NULL, &timeout);
-        if (result < 0) {
-            if (errno == EINTR && stop_requested) {
-                LOG__INFO("Program termination detected");
-                break;
-
-            } else if (errno == EINTR && reconfigure) {
-                //printf("Signalunterbrechung erkannt. Reconfigure....\n");
-                // implement later
-                continue;
-            } else {
-                perror("select");
-                break;
-            }
-
-        } else if (result == 0) {
-            continue;
+    if (get_prog_function() == mavrptreplay) {
+        // the recorded frames come in place of the serial port
+        if (strlen(options.replay_file) == 0) {
+            fprintf(stderr, "%s: replay: no tlog given (--replay)\n", progname);
+            return 1;
         }
-        
-        LOG__TRACE("try to read serial port...");
-        if (FD_ISSET(serial_fd, &readfds)) {
-            ssize_t len = readSerial(serial_fd, buffer, sizeof(buffer));
-            LOG__TRACE("read %d bytes from serial port...", len);
-            if (len > 0) {
-                send_udp_packet(udp_fd, buffer, len);
-            }
-        }
-
-        LOG__TRACE("try to read udp port...");
-        if (FD_ISSET(udp_fd, &readfds)) {
-            ssize_t len = recv_udp_packet(udp_fd, buffer, sizeof(buffer));
-            LOG__TRACE("read %d bytes from udp port...", len);
-            if (len > 0) {
-                writeSerial(serial_fd, buffer, len);
-            }
+        if (replay_start(options.replay_file, options.replay_speed, options.replay_port,
+                options.baudrate, &options.serial) < 0) {
+            return 1;
         }
     }
 
-    while (false) {
-        int len = readSerial(serial_fd, buffer, sizeof (buffer));
-        if (len <= 0) {
-            usleep(1000);
-            continue;
+    if (get_prog_function() == mavrptserver) {
+        // air station clients come in on one port, forward to the ground station(s)
+        if (options.endpoint_count == 0) {
+            fprintf(stderr, "%s: no ground station (gcs) configured\n", progname);
+            return 1;
         }
-        //printf("begin len%d\n", len);
-        for (int i = 0; i < len; ++i) {
-            if (mavlink_parse_char(MAVLINK_COMM_0, buffer[i], &msg, &status)) {
-
-                if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                    mavlink_heartbeat_t hb;
-                    mavlink_msg_heartbeat_decode(&msg, &hb);
-                    bool armed = hb.base_mode & MAV_MODE_FLAG_SAFETY_ARMED;
-                    printf("ARMED STATUS: %s\n", armed ? "YES" : "NO");
-
-                } else if (msg.msgid == MAVLINK_MSG_ID_SYS_STATUS) {
-                    mavlink_sys_status_t sys;
-                    mavlink_msg_sys_status_decode(&msg, &sys);
-
-                    float voltage = sys.voltage_battery / 1000.0f; // mV → V
-                    float current = sys.current_battery / 100.0f; // cA → A
-
-                    printf("Batterie: %.2f V, %.2f A\n", voltage, current);
-
-                } else if (msg.msgid == MAVLINK_MSG_ID_BATTERY_STATUS) { /* 147 */
-                    mavlink_battery_status_t bat;
-                    mavlink_msg_battery_status_decode(&msg, &bat);
-
-                    /*printf("Battery ID: %d\n", bat.id);
-                    for (int i = 0; i < bat.cell_count; ++i) {
-                        if (bat.voltages[i] != UINT16_MAX)
-                            printf("        Zelle %d: %.3f V\n", i + 1, bat.voltages[i] / 1000.0f);
-                    }
-                    printf("  Strom: %.2f A\n", bat.current_battery / 100.0f);*/
-
-                } else if (msg.msgid == MAVLINK_MSG_ID_POWER_STATUS            /* 125 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_SERVO_OUTPUT_RAW           /*  36 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_SYSTEM_TIME                /*   2 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT      /* 62 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_RC_CHANNELS                /* 65 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_RAW_IMU                    /* 27 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_GPS_RAW_INT                /* 24 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_SCALED_PRESSURE            /* 29 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_ATTITUDE                   /* 30 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_LOCAL_POSITION_NED         /* 32 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_GLOBAL_POSITION_INT        /* 33 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_MISSION_CURRENT            /* 42*/ ||
-                        msg.msgid == MAVLINK_MSG_ID_VFR_HUD                    /* 74 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT /* 87 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_TIMESYNC                   /* 111 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_TERRAIN_REQUEST            /* 133 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_TERRAIN_CHECK              /* 135 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_TERRAIN_REPORT             /* 136 */ ||
-                        msg.msgid == MAVLINK_MSG_ID_VIBRATION                  /* 241 */
-                        ) {
-
-                    //printf("### finde diese msg-id %d\n", msg.msgid);
-
-                } else {
-                    printf("### unknown msg-id %d\n", msg.msgid);
-                }
-
-                uint8_t out_buf[MAVLINK_MAX_PACKET_LEN];
-                int out_len = mavlink_msg_to_send_buffer(out_buf, &msg);
-                send_udp_packet(udp_fd, out_buf, out_len);
-            }
+        link_t *server = relay_add_udp_server(options.port);
+        if (!server) {
+            perror("UDP server socket failed");
+            return 1;
         }
-        //printf("ende\n");
-
-        uint8_t bufferRX[1024];
-        int lenRX = recv_udp_packet(udp_fd, bufferRX, sizeof(bufferRX));
-        //printf("empfange per udp %d bytes\n", lenRX);
-        if (lenRX <= 0) {
-            usleep(1000);
-            continue;
+        relay_set_coalesce(server, options.mtu, options.coalesce_ms);
+        server->version = options.version;
+        if (options.compress) relay_set_compress(server);
+        if (options.fec > 0) relay_set_fec(server, options.fec, options.fec_ms);
+    } else if (options.endpoint_count == 0) {
+        // no endpoints configured: one serial port (or the replay) to one udp endpoint
+        if (get_prog_function() != mavrptreplay &&
+                !relay_add_serial(options.device, options.baudrate, &options.serial)) {
+            perror("Serial open failed");
+            return 1;
         }
-        for (int i = 0; i < lenRX; ++i) {
-            mavlink_message_t msgRX;
-            mavlink_status_t statusRX;
-            if (mavlink_parse_char(MAVLINK_COMM_1, bufferRX[i], &msgRX, &statusRX)) {
-                printf("[UDP] MAVLink msgid: %d\n", msgRX.msgid);
-                // → Hier MAVLink von Mission Planner verarbeiten
-                uint8_t out_buf[MAVLINK_MAX_PACKET_LEN];
-                int out_len = mavlink_msg_to_send_buffer(out_buf, &msgRX);
-                printf("upd-rx-> len:%d\n", out_len);
-                writeSerial(serial_fd, out_buf, out_len);
-            }
+        link_t *client = relay_add_udp_client(options.server, options.port);
+        if (!client) {
+            perror("UDP socket failed");
+            return 1;
         }
-        //writeSerial(serial_fd, bufferRX, sizeof(bufferRX));
-        
+        relay_set_coalesce(client, options.mtu, options.coalesce_ms);
+        client->version = options.version;
+        if (options.compress) relay_set_compress(client);
+        if (options.fec > 0) relay_set_fec(client, options.fec, options.fec_ms);
     }
 
+    for (int i = 0; i < options.endpoint_count; i++) {
+        endpoint_opt_t *ep = &options.endpoints[i];
+        if (ep->type == ENDPOINT_SERIAL && ep->baudrate == 0) {
+            ep->baudrate = options.baudrate;
+        }
+        if (!relay_add_endpoint(ep)) {
+            fprintf(stderr, "%s: endpoint %d could not be opened\n", progname, i + 1);
+            return 1;
+        }
+    }
+
+    write_pidfile(PID_FILE);
+
+    const int signals[] = {SIGINT, SIGTERM, SIGHUP};
+    if (event_add_signals(signals, sizeof (signals) / sizeof (signals[0]), on_signal_event, NULL) < 0) {
+        LOG__ERROR("could not register event sources");
+        return 1;
+    }
+
+    event_run(&stop_requested);
+    LOG__INFO("Program termination detected");
+
+    relay_status();
+    recorder_status();
+
     LOG__INFO("Program will be terminated");
-    closeSerial(serial_fd);
-    close(udp_fd);
+    resolver_close();
+    replay_close();
+    relay_close();
+    recorder_close();
+    event_close();
     unlink(PID_FILE);
+    eventlog_close();
+    log_close();
     return 0;
 }
 
@@ -38,6 +38,8 @@
 
 #include "option.h"
 #include "logging.h"
+#include "framer.h"
+#include "replay.h"
 
 #include "cJSON.h"
 
@@ -54,12 +56,27 @@ static struct option cmd_options[] = {
     {"help",      no_argument,       0, 'h'},
     {"daemon",    no_argument,       0, 'D'},
     {"loglevel",  required_argument, 0, 'L'},
+    {"eventlog",  required_argument, 0, 'E'},
 
     {"device",    required_argument, 0, 'd'},
     {"baudrate",  required_argument, 0, 'b'},
+    {"lowlatency", no_argument,      0, 'l'},
+    {"rtscts",    no_argument,       0, 'r'},
+    {"readbatch", required_argument, 0, 'B'},
+    {"threaded",  no_argument,       0, 'T'},
 
     {"server",    required_argument, 0, 's'},
     {"port",      required_argument, 0, 'p'},
+    {"gcs",       required_argument, 0, 'g'},
+    {"mtu",       required_argument, 0, 'm'},
+    {"mavlink",   required_argument, 0, 'M'},
+    {"compress",  no_argument,       0, 'z'},
+    {"fec",       required_argument, 0, 'F'},
+    {"dedup",     no_argument,       0, 'u'},
+    {"tlog",      required_argument, 0, 't'},
+    {"replay",    required_argument, 0, 'R'},
+    {"speed",     required_argument, 0, 'S'},
+    {"input",     required_argument, 0, 'I'},
 
     {"config",    required_argument, 0, 'c'},
     {"function",  required_argument, 0, 'f'},
@@ -75,10 +92,215 @@ static struct option json_options[] = {
 };
 */
 
+/**
+ * add a ground station endpoint "host:port" or "[ipv6]:port" (udp)
+ * @param cfg
+ * @param endpoint
+ * @return 0 if ok
+ */
+static int add_gcs_endpoint(options_t* cfg, const char* endpoint) {
+    const char *colon = strrchr(endpoint, ':');
+    if (!colon || cfg->endpoint_count >= OPTIONS_MAX_ENDPOINTS) {
+        fprintf(stderr, "%s: invalid or too many gcs endpoints: %s\n", progname, endpoint);
+        return -1;
+    }
+    endpoint_opt_t *gcs = &cfg->endpoints[cfg->endpoint_count];
+    memset(gcs, 0, sizeof (*gcs));
+    gcs->type = ENDPOINT_UDP;
+    size_t len = colon - endpoint;
+    if (endpoint[0] == '[' && len >= 2 && endpoint[len - 1] == ']') {
+        endpoint++;
+        len -= 2;
+    }
+    if (len >= sizeof (gcs->server)) len = sizeof (gcs->server) - 1;
+    memcpy(gcs->server, endpoint, len);
+    gcs->server[len] = '\0';
+    gcs->port = atoi(colon + 1);
+    cfg->endpoint_count++;
+    return 0;
+}
+
+/**
+ * tuning of a serial port, in an endpoint or the section of the function
+ * {"low_latency": true, "rtscts": false, "read_batch": 32, "read_wait_ms": 5, "threaded": false}
+ */
+static void parse_serial_opt(const cJSON* item, serial_opt_t* opt) {
+    cJSON* value = cJSON_GetObjectItemCaseSensitive(item, "low_latency");
+    if (cJSON_IsBool(value)) {
+        opt->low_latency = cJSON_IsTrue(value);
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "rtscts");
+    if (cJSON_IsBool(value)) {
+        opt->rtscts = cJSON_IsTrue(value);
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "read_batch");
+    if (cJSON_IsNumber(value)) {
+        opt->read_batch = value->valueint;
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "read_wait_ms");
+    if (cJSON_IsNumber(value)) {
+        opt->read_wait_ms = value->valueint;
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "threaded");
+    if (cJSON_IsBool(value)) {
+        opt->threaded = cJSON_IsTrue(value);
+    }
+}
+
+/**
+ * replay input: "pty", "udp" or "udp:<port>"
+ * @return 0 if ok
+ */
+static int parse_replay_input(const char* value, options_t* cfg) {
+    if (strcmp(value, "pty") == 0) {
+        cfg->replay_port = 0;
+    } else if (strncmp(value, "udp", 3) == 0) {
+        cfg->replay_port = (value[3] == ':') ? atoi(value + 4) : REPLAY_UDP_PORT;
+    } else {
+        LOG__ERROR("replay input %s unknown, use pty or udp[:port]", value);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * "v1" or "v2", everything else keeps the version of the frames
+ */
+static MavVersion parse_version(const char* value) {
+    if (strcmp(value, "v1") == 0) return MAVVERSION_V1;
+    if (strcmp(value, "v2") == 0) return MAVVERSION_V2;
+    return MAVVERSION_KEEP;
+}
+
+/**
+ * parse one entry of the "endpoints" array, e.g.
+ * {"type": "udp", "server": "10.0.0.1", "port": 14550, "direction": "out", "filter": {"block": [27, 241]},
+ *  "rates": {"ATTITUDE": 5, "RAW_IMU": 1, "33": 2}, "mtu": 1400, "coalesce_ms": 5, "mavlink": "v2",
+ *  "compress": true, "fec": 8, "fec_ms": 50}
+ *
+ * @param item
+ * @param ep
+ * @return 0 if ok
+ */
+static int parse_endpoint(const cJSON* item, endpoint_opt_t* ep) {
+    memset(ep, 0, sizeof (*ep));
+
+    cJSON* type = cJSON_GetObjectItemCaseSensitive(item, "type");
+    if (!cJSON_IsString(type)) {
+        LOG__WARN("endpoint without type ignored");
+        return -1;
+    }
+    if (strcmp(type->valuestring, "serial") == 0) {
+        ep->type = ENDPOINT_SERIAL;
+    } else if (strcmp(type->valuestring, "udp") == 0) {
+        ep->type = ENDPOINT_UDP;
+    } else if (strcmp(type->valuestring, "udpserver") == 0) {
+        ep->type = ENDPOINT_UDP_SERVER;
+    } else if (strcmp(type->valuestring, "tcp") == 0) {
+        ep->type = ENDPOINT_TCP;
+    } else {
+        LOG__WARN("endpoint type '%s' unknown", type->valuestring);
+        return -1;
+    }
+
+    cJSON* value = cJSON_GetObjectItemCaseSensitive(item, "device");
+    if (cJSON_IsString(value)) {
+        strncpy(ep->device, value->valuestring, sizeof (ep->device) - 1);
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "baudrate");
+    if (cJSON_IsNumber(value)) {
+        ep->baudrate = value->valueint;
+    }
+    parse_serial_opt(item, &ep->serial);
+    value = cJSON_GetObjectItemCaseSensitive(item, "server");
+    if (cJSON_IsString(value)) {
+        strncpy(ep->server, value->valuestring, sizeof (ep->server) - 1);
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "port");
+    if (cJSON_IsNumber(value)) {
+        ep->port = value->valueint;
+    }
+
+    value = cJSON_GetObjectItemCaseSensitive(item, "mtu");
+    if (cJSON_IsNumber(value)) {
+        ep->mtu = value->valueint;
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "coalesce_ms");
+    if (cJSON_IsNumber(value)) {
+        ep->coalesce_ms = value->valueint;
+    }
+
+    value = cJSON_GetObjectItemCaseSensitive(item, "mavlink");
+    if (cJSON_IsString(value)) {
+        ep->version = parse_version(value->valuestring);
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "compress");
+    if (cJSON_IsBool(value)) {
+        ep->compress = cJSON_IsTrue(value);
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "fec");
+    if (cJSON_IsNumber(value)) {
+        ep->fec = value->valueint;
+    }
+    value = cJSON_GetObjectItemCaseSensitive(item, "fec_ms");
+    if (cJSON_IsNumber(value)) {
+        ep->fec_ms = value->valueint;
+    }
+
+    value = cJSON_GetObjectItemCaseSensitive(item, "direction");
+    if (cJSON_IsString(value)) {
+        if (strcmp(value->valuestring, "in") == 0) {
+            ep->direction = DIRECTION_IN;
+        } else if (strcmp(value->valuestring, "out") == 0) {
+            ep->direction = DIRECTION_OUT;
+        } else {
+            ep->direction = DIRECTION_BOTH;
+        }
+    }
+
+    cJSON* filter = cJSON_GetObjectItemCaseSensitive(item, "filter");
+    if (filter) {
+        cJSON* list = cJSON_GetObjectItemCaseSensitive(filter, "allow");
+        if (!cJSON_IsArray(list)) {
+            list = cJSON_GetObjectItemCaseSensitive(filter, "block");
+            ep->filter_block = cJSON_IsArray(list);
+        }
+        cJSON_ArrayForEach(value, list) {
+            if (cJSON_IsNumber(value) && ep->filter_count < OPTIONS_MAX_FILTER) {
+                ep->filter[ep->filter_count++] = (uint32_t) value->valueint;
+            }
+        }
+    }
+
+    // max. frames per second by message name or msgid
+    cJSON* rates = cJSON_GetObjectItemCaseSensitive(item, "rates");
+    cJSON_ArrayForEach(value, rates) {
+        uint32_t msgid;
+        if (!cJSON_IsNumber(value) || value->valuedouble <= 0 || !framer_msgid_from_name(value->string, &msgid)) {
+            LOG__WARN("rate cap '%s' ignored", value->string ? value->string : "?");
+            continue;
+        }
+        if (ep->rate_count < OPTIONS_MAX_RATES) {
+            ep->rate_msgid[ep->rate_count] = msgid;
+            ep->rate_hz[ep->rate_count] = (float) value->valuedouble;
+            ep->rate_count++;
+        }
+    }
+
+    if ((ep->type == ENDPOINT_SERIAL && strlen(ep->device) == 0) ||
+            ((ep->type == ENDPOINT_UDP || ep->type == ENDPOINT_TCP) && strlen(ep->server) == 0) ||
+            (ep->type != ENDPOINT_SERIAL && ep->port <= 0)) {
+        LOG__WARN("endpoint '%s' incomplete, ignored", type->valuestring);
+        return -1;
+    }
+    return 0;
+}
+
 void parse_options(int argc, char *argv[]) {
     int opt = 0;
     int long_index = 0;
 
+    optind = 1;     // parse_config() already went through argv
     while ((opt = getopt_long_only(argc, argv, "", cmd_options, &long_index)) != -1) {
         switch (opt) {
             case 'h':
@@ -92,18 +314,38 @@ void parse_options(int argc, char *argv[]) {
 
             case 'L':
             {
-                char *str = strdup(optarg);
-                char *s = str;
-                while (*s) {
-                    *s = toupper((unsigned char) *s);
-                    s++;
+                // upper case, it is compared with the default later
+                size_t i;
+                for (i = 0; optarg[i] && i < sizeof options.loglevel - 1; i++) {
+                    options.loglevel[i] = toupper((unsigned char) optarg[i]);
                 }
-                log_set_level(loglevel_from_string(str));
-                strncpy(options.loglevel, str, sizeof options.loglevel);
+                options.loglevel[i] = '\0';
                 log_set_level(loglevel_from_string(options.loglevel));
             }
                 break;
 
+            case 'E':
+                strncpy(options.eventlog, optarg, sizeof options.eventlog - 1);
+                break;
+
+            case 't':
+                strncpy(options.tlog, optarg, sizeof options.tlog - 1);
+                break;
+
+            case 'R':
+                strncpy(options.replay_file, optarg, sizeof options.replay_file - 1);
+                break;
+
+            case 'S':
+                options.replay_speed = atof(optarg);
+                break;
+
+            case 'I':
+                if (parse_replay_input(optarg, &options) < 0) {
+                    print_usage();
+                }
+                break;
+
             case 'd':
                 strncpy(options.device, optarg, sizeof options.device);
                 break;
@@ -112,7 +354,59 @@ void parse_options(int argc, char *argv[]) {
                 options.baudrate = atoi(optarg);
                 break;
 
+            case 'l':
+                options.serial.low_latency = true;
+                break;
+
+            case 'r':
+                options.serial.rtscts = true;
+                break;
+
+            case 'B':
+                options.serial.read_batch = atoi(optarg);
+                break;
+
+            case 'T':
+                options.serial.threaded = true;
+                break;
+
+            case 's':
+                strncpy(options.server, optarg, sizeof options.server - 1);
+                break;
+
             case 'p':
+                options.port = atoi(optarg);
+                break;
+
+            case 'm':
+                options.mtu = atoi(optarg);
+                break;
+
+            case 'M':
+                options.version = parse_version(optarg);
+                break;
+
+            case 'z':
+                options.compress = true;
+                break;
+
+            case 'F':
+                options.fec = atoi(optarg);
+                break;
+
+            case 'u':
+                options.dedup = true;
+                break;
+
+            case 'c':
+            case 'f':
+                // already handled by parse_config()
+                break;
+
+            case 'g':
+                if (add_gcs_endpoint(&options, optarg) < 0) {
+                    print_usage();
+                }
                 break;
 
             default:
@@ -245,6 +539,14 @@ int load_config_from_json(const char* filename, options_t* cfg, const char* func
         if (cJSON_IsNumber(logitem)) {
             cfg->logfilesize = logitem->valueint;
         }
+        logitem = cJSON_GetObjectItemCaseSensitive(global, "eventlog");
+        if (cJSON_IsString(logitem) && logitem->valuestring) {
+            strncpy(cfg->eventlog, logitem->valuestring, sizeof (cfg->eventlog) - 1);
+        }
+        logitem = cJSON_GetObjectItemCaseSensitive(global, "eventlogsize");
+        if (cJSON_IsNumber(logitem)) {
+            cfg->eventlogsize = logitem->valueint;
+        }
         
     }
 
@@ -266,6 +568,7 @@ int load_config_from_json(const char* filename, options_t* cfg, const char* func
     if (cJSON_IsNumber(item)) {
         cfg->baudrate = item->valueint;
     }
+    parse_serial_opt(section, &cfg->serial);
 
     item = cJSON_GetObjectItemCaseSensitive(section, "server");
     if (cJSON_IsString(item) && item->valuestring) {
@@ -277,6 +580,99 @@ int load_config_from_json(const char* filename, options_t* cfg, const char* func
         cfg->port = item->valueint;
     }
 
+    item = cJSON_GetObjectItemCaseSensitive(section, "mtu");
+    if (cJSON_IsNumber(item)) {
+        cfg->mtu = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "coalesce_ms");
+    if (cJSON_IsNumber(item)) {
+        cfg->coalesce_ms = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "mavlink");
+    if (cJSON_IsString(item)) {
+        cfg->version = parse_version(item->valuestring);
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "compress");
+    if (cJSON_IsBool(item)) {
+        cfg->compress = cJSON_IsTrue(item);
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "fec");
+    if (cJSON_IsNumber(item)) {
+        cfg->fec = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "fec_ms");
+    if (cJSON_IsNumber(item)) {
+        cfg->fec_ms = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "dedup");
+    if (cJSON_IsBool(item)) {
+        cfg->dedup = cJSON_IsTrue(item);
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "tlog");
+    if (cJSON_IsString(item) && item->valuestring) {
+        strncpy(cfg->tlog, item->valuestring, sizeof (cfg->tlog) - 1);
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "tlog_size");
+    if (cJSON_IsNumber(item)) {
+        cfg->tlog_size = item->valueint;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "tlog_minutes");
+    if (cJSON_IsNumber(item)) {
+        cfg->tlog_minutes = item->valueint;
+    }
+
+    // replay: {"file": "flight.tlog", "speed": 1.0, "input": "pty"} or "input": "udp", "input_port": 14560
+    item = cJSON_GetObjectItemCaseSensitive(section, "file");
+    if (cJSON_IsString(item) && item->valuestring) {
+        strncpy(cfg->replay_file, item->valuestring, sizeof (cfg->replay_file) - 1);
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "speed");
+    if (cJSON_IsNumber(item)) {
+        cfg->replay_speed = item->valuedouble;
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "input");
+    if (cJSON_IsString(item) && item->valuestring) {
+        parse_replay_input(item->valuestring, cfg);
+    }
+    item = cJSON_GetObjectItemCaseSensitive(section, "input_port");
+    if (cJSON_IsNumber(item) && cfg->replay_port > 0) {
+        cfg->replay_port = item->valueint;
+    }
+
+    // mavrptserver: list of ground stations [{"server": "127.0.0.1", "port": 14550}, ...]
+    item = cJSON_GetObjectItemCaseSensitive(section, "gcs");
+    if (cJSON_IsArray(item)) {
+        cJSON* gcsitem;
+        cJSON_ArrayForEach(gcsitem, item) {
+            cJSON* server = cJSON_GetObjectItemCaseSensitive(gcsitem, "server");
+            cJSON* port = cJSON_GetObjectItemCaseSensitive(gcsitem, "port");
+            if (!cJSON_IsString(server) || !cJSON_IsNumber(port) || cfg->endpoint_count >= OPTIONS_MAX_ENDPOINTS) {
+                LOG__WARN("invalid gcs entry ignored");
+                continue;
+            }
+            endpoint_opt_t *gcs = &cfg->endpoints[cfg->endpoint_count++];
+            memset(gcs, 0, sizeof (*gcs));
+            gcs->type = ENDPOINT_UDP;
+            strncpy(gcs->server, server->valuestring, sizeof (gcs->server) - 1);
+            gcs->port = port->valueint;
+        }
+    }
+
+    // any number of serial ports and udp/tcp endpoints
+    item = cJSON_GetObjectItemCaseSensitive(section, "endpoints");
+    if (cJSON_IsArray(item)) {
+        cJSON* epitem;
+        cJSON_ArrayForEach(epitem, item) {
+            if (cfg->endpoint_count >= OPTIONS_MAX_ENDPOINTS) {
+                LOG__WARN("too many endpoints, max %d", OPTIONS_MAX_ENDPOINTS);
+                break;
+            }
+            if (parse_endpoint(epitem, &cfg->endpoints[cfg->endpoint_count]) == 0) {
+                cfg->endpoint_count++;
+            }
+        }
+    }
+
     item = cJSON_GetObjectItemCaseSensitive(section, "loglevel");
     if (cJSON_IsString(item) && item->valuestring) {
         // local loglevel overwrite
@@ -308,6 +704,24 @@ void get_program_name(char *argv[]) {
     }
 }
 
+/**
+ * returns the program function, given by --function or the program name
+ * @return
+ */
+ProgFunction get_prog_function(void) {
+    const char *function = jsonconfig.function ? jsonconfig.function : progname;
+    if (strcmp(function, prognames.mav_repeater_server) == 0) {
+        return mavrptserver;
+    }
+    if (strcmp(function, prognames.mav_repeater_client) == 0) {
+        return mavrptclient;
+    }
+    if (strcmp(function, prognames.mav_repeater_replay) == 0) {
+        return mavrptreplay;
+    }
+    return mavrpt;
+}
+
 void print_usage() {
     printf("Usage: \n");
 
@@ -316,13 +730,29 @@ void print_usage() {
             "\n"
             "  --device      Serial MAVLink device (%s by default)\n"
             "  --baudrate    Serial MAVLink baudrate (%d by default)\n"
+            "  --lowlatency  Serial: set ASYNC_LOW_LATENCY (USB adapters without latency timer)\n"
+            "  --rtscts      Serial: RTS/CTS hardware flow control\n"
+            "  --readbatch   Serial: wake up when n bytes are waiting, the rest is read after 5 ms (1 by default)\n"
+            "  --threaded    Serial: read and write the port in own threads, the relay loop only routes\n"
             "  --server      Server address (%s by default)\n"
-            "  --port        Server port (%d by default)\n"
+            "  --port        Server port (%d by default), mavrptserver: port for the air station clients\n"
+            "  --gcs         mavrptserver: ground station host:port, may be given more than once\n"
+            "  --mtu         Pack frames into udp datagrams of up to mtu bytes (sent within 5 ms)\n"
+            "  --mavlink     v2: send MAVLink v2 with truncated payloads on the udp side, v1: convert to v1\n"
+            "  --compress    Compress the frames between mavrptclient and mavrptserver (both sides)\n"
+            "  --fec         Send one parity datagram per n datagrams, a lost datagram is rebuilt (2..32)\n"
+            "  --dedup       Forward only the first copy of frames which come over redundant links\n"
+            "  --tlog        Record all received frames into tlog files in this directory (new file every 60 min.)\n"
             "  --loglevel    Setting the log level (%s by default)\n"
+            "  --eventlog    Write a binary event log of every frame to this file (print it with mavrptevlog)\n"
             "  --daemon      Runs the program in the background and detaches it from the input shell\n"
             "  --function    Program function (client, server, direct). Is actually controlled via the program name (mavrptclient, mavrptserver, mavrpt)\n"
+            "  --replay      replay: tlog file which is fed into the relay in place of the serial port\n"
+            "  --speed       replay: 1 = original timing (default), n = n times faster, 0 = as fast as possible\n"
+            "  --input       replay: pty (default) or udp[:port] (port %d by default)\n"
             "  --help        Display this help\n"
-            , progname, options.device_dflt, options.baudrate_dflt, options.server, options.port, options.loglevel_dflt );
+            , progname, options.device_dflt, options.baudrate_dflt, options.server, options.port, options.loglevel_dflt,
+            REPLAY_UDP_PORT);
 
     printf(
             "\n or\n"
@@ -334,7 +764,8 @@ void print_usage() {
             "\n  Program name or function name:"
             "  mavrptclient - MAVLink repeater Client routes the data from the Air Station through the existing IP tunnel to the Ground Station server.\n"
             "  mavrptserver - MAVLink repeater Server handles the connection from the IP tunnel of the air station/clients and establishes a connection to a ground station software.\n"
-            "  mavrpt       - MAVLink repeater forwards directly from the air station to the ground station. Similar to MAVProxy.\n");
+            "  mavrpt       - MAVLink repeater forwards directly from the air station to the ground station. Similar to MAVProxy.\n"
+            "  replay       - (--function replay) feeds a recorded tlog through the relay to the udp endpoint, for load tests.\n");
     
     exit(EXIT_FAILURE);
 }
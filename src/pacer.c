@@ -0,0 +1,113 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   pacer.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "pacer.h"
+#include "common/mavlink.h"
+
+static void set_depth(pacer_t *pacer) {
+    pacer->depth = (uint64_t) pacer->rate * PACER_BURST_MS;
+    if (pacer->depth < MAVLINK_MAX_PACKET_LEN * 1000ULL) {
+        pacer->depth = MAVLINK_MAX_PACKET_LEN * 1000ULL;
+    }
+    if (pacer->tokens > pacer->depth) {
+        pacer->tokens = pacer->depth;
+    }
+}
+
+/**
+ * pace a serial line: the capacity is baudrate / bits per character
+ * @param pacer
+ * @param baudrate
+ * @param char_bits incl. start, parity and stop bits (8N1: 10)
+ * @param now ms
+ */
+void pacer_init(pacer_t *pacer, int baudrate, int char_bits, uint64_t now) {
+    pacer->rate = (baudrate > 0 && char_bits > 0) ? (uint32_t) (baudrate / char_bits) : 0;
+    pacer->tokens = 0;
+    pacer->last_ms = now;
+    pacer->delayed = 0;
+    set_depth(pacer);
+    pacer->tokens = pacer->depth;
+}
+
+/**
+ * change the rate, e.g. below the line rate for a radio
+ * @param pacer
+ * @param rate bytes per second
+ */
+void pacer_set_rate(pacer_t *pacer, uint32_t rate) {
+    pacer->rate = rate;
+    set_depth(pacer);
+}
+
+static inline void refill(pacer_t *pacer, uint64_t now) {
+    if (now > pacer->last_ms) {
+        pacer->tokens += (now - pacer->last_ms) * pacer->rate;
+        if (pacer->tokens > pacer->depth) {
+            pacer->tokens = pacer->depth;
+        }
+        pacer->last_ms = now;
+    }
+}
+
+/**
+ * take the tokens for a frame
+ * @param pacer
+ * @param len bytes
+ * @param now ms
+ * @return true if the frame may be sent now
+ */
+bool pacer_take(pacer_t *pacer, int len, uint64_t now) {
+    if (pacer->rate == 0) {
+        return true;
+    }
+    refill(pacer, now);
+    uint64_t need = (uint64_t) len * 1000;
+    if (pacer->tokens < need) {
+        pacer->delayed++;
+        return false;
+    }
+    pacer->tokens -= need;
+    return true;
+}
+
+/**
+ * time until a frame of len bytes may be sent, after pacer_take() failed
+ * @param pacer
+ * @param len bytes
+ * @return ms, at least 1
+ */
+int pacer_wait_ms(const pacer_t *pacer, int len) {
+    uint64_t need = (uint64_t) len * 1000;
+    if (pacer->rate == 0 || pacer->tokens >= need) {
+        return 1;
+    }
+    uint64_t ms = (need - pacer->tokens + pacer->rate - 1) / pacer->rate;
+    return ms > 0 ? (int) ms : 1;
+}
@@ -0,0 +1,196 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   ratecap.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "ratecap.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * rate caps of a link, the table is allocated only for links with caps
+ * @return table or NULL
+ */
+ratecap_t* ratecap_create(void) {
+    return calloc(1, sizeof (ratecap_t));
+}
+
+/**
+ * limit a message to hz frames per second
+ * @param rc
+ * @param msgid
+ * @param hz
+ * @return 0 if ok
+ */
+int ratecap_add(ratecap_t *rc, uint32_t msgid, float hz) {
+    if (msgid >= RATECAP_MSGIDS || hz <= 0 || rc->count >= RATECAP_MAX) {
+        return -1;
+    }
+    ratecap_slot_t *slot;
+    if (rc->index[msgid] != 0) {
+        slot = &rc->slots[rc->index[msgid] - 1];    // given twice: the last one counts
+    } else {
+        slot = &rc->slots[rc->count++];
+        rc->index[msgid] = (uint8_t) rc->count;
+    }
+    memset(slot, 0, sizeof (*slot));
+    slot->msgid = msgid;
+    slot->interval_ms = (uint32_t) (1000.0f / hz + 0.5f);
+    return 0;
+}
+
+static inline uint32_t source_hash(int slot, uint8_t sysid, uint8_t compid) {
+    uint32_t key = ((uint32_t) slot << 16) | ((uint32_t) sysid << 8) | compid;
+    return (key * 2654435761u) >> 16;
+}
+
+/**
+ * source of a frame, new sources are added. Every vehicle of a fleet
+ * keeps its own entry, so a cap applies to each of them.
+ * @return source or NULL if the table is full
+ */
+static ratecap_source_t* find_source(ratecap_t *rc, int slot, const mav_frame_t *frame) {
+    uint32_t i = source_hash(slot, frame->sysid, frame->compid);
+
+    for (int n = 0; n < RATECAP_SOURCES; n++, i++) {
+        ratecap_source_t *src = &rc->sources[i & (RATECAP_SOURCES - 1)];
+        if (!src->used) {
+            src->used = true;
+            src->slot = (uint8_t) slot;
+            src->sysid = frame->sysid;
+            src->compid = frame->compid;
+            src->next_ms = 0;
+            rc->sources_used++;
+            return src;
+        }
+        if (src->slot == slot && src->sysid == frame->sysid && src->compid == frame->compid) {
+            return src;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * check a frame against the cap of its msgid
+ * @param rc
+ * @param fb
+ * @param peer target session or NULL
+ * @param now ms
+ * @return true to send the frame now, false if it is held (a reference is taken)
+ *         or dropped
+ */
+bool ratecap_admit(ratecap_t *rc, framebuf_t *fb, const client_key_t *peer, uint64_t now) {
+    uint32_t msgid = fb->frame.msgid;
+    if (msgid >= RATECAP_MSGIDS || rc->index[msgid] == 0) {
+        return true;
+    }
+    ratecap_slot_t *slot = &rc->slots[rc->index[msgid] - 1];
+    ratecap_source_t *src = find_source(rc, rc->index[msgid] - 1, &fb->frame);
+    if (!src) {
+        rc->full++;     // too many sources, dropped rather than sent uncapped
+        return false;
+    }
+
+    if (now >= src->next_ms) {
+        if (src->pending) {
+            // a held frame is older than this one
+            framebuf_unref(src->pending);
+            src->pending = NULL;
+            rc->replaced++;
+        }
+        src->next_ms = now + slot->interval_ms;
+        return true;
+    }
+
+    if (src->pending) {
+        framebuf_unref(src->pending);
+        rc->replaced++;
+    } else {
+        rc->held++;
+    }
+    src->pending = framebuf_ref(fb);
+    src->has_peer = (peer != NULL);
+    if (peer) {
+        src->peer = *peer;
+    }
+    return false;
+}
+
+/**
+ * time of the next held frame
+ * @param rc
+ * @return ms or 0 if no frame is held
+ */
+uint64_t ratecap_next_ms(const ratecap_t *rc) {
+    uint64_t next = 0;
+    for (int i = 0; i < RATECAP_SOURCES; i++) {
+        const ratecap_source_t *src = &rc->sources[i];
+        if (src->pending && (next == 0 || src->next_ms < next)) {
+            next = src->next_ms;
+        }
+    }
+    return next;
+}
+
+/**
+ * take a held frame whose time has come
+ * @param rc
+ * @param now ms
+ * @param peer target session of the frame
+ * @param has_peer
+ * @return frame (the caller releases the reference) or NULL
+ */
+framebuf_t* ratecap_take_due(ratecap_t *rc, uint64_t now, client_key_t *peer, bool *has_peer) {
+    for (int i = 0; i < RATECAP_SOURCES; i++) {
+        ratecap_source_t *src = &rc->sources[i];
+        if (src->pending && now >= src->next_ms) {
+            framebuf_t *fb = src->pending;
+            src->pending = NULL;
+            src->next_ms = now + rc->slots[src->slot].interval_ms;
+            *has_peer = src->has_peer;
+            if (src->has_peer) {
+                *peer = src->peer;
+            }
+            return fb;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * release the held frames and the table
+ * @param rc
+ */
+void ratecap_free(ratecap_t *rc) {
+    if (!rc) return;
+    for (int i = 0; i < RATECAP_SOURCES; i++) {
+        if (rc->sources[i].pending) {
+            framebuf_unref(rc->sources[i].pending);
+        }
+    }
+    free(rc);
+}
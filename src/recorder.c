@@ -0,0 +1,284 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   recorder.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "recorder.h"
+#include "spsc.h"
+#include "logging.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+/*
+ * tlog recorder: every received frame is written as 8 byte time stamp
+ * (µs since 1970, big endian) plus the raw frame, the format of the ground
+ * stations. The event loop only copies the frame into a ring, the recorder
+ * thread writes it into a preallocated, memory mapped file. If the disk
+ * falls behind, the ring runs full and frames are dropped and counted, the
+ * forwarding never waits. A new file is started when the file is full or
+ * after rotate_minutes.
+ */
+
+bool recorder_active = false;
+
+static char directory[200];
+static size_t file_size;
+static int rotate_s;
+static spsc_t ring;                 // event loop -> recorder thread
+static uint32_t published = 0;
+static recorder_stats_t stats;
+static pthread_t thread;
+static bool thread_stop = false;
+static int wake_fd = -1;
+
+// recorder thread
+static char filename[256];
+static int fd = -1;
+static uint8_t *map = NULL;
+static size_t used = 0;
+static time_t opened = 0;
+
+/**
+ * unmap and cut the file to the written frames
+ */
+static void close_file(void) {
+    if (map) {
+        munmap(map, file_size);
+        map = NULL;
+    }
+    if (fd >= 0) {
+        if (ftruncate(fd, used) < 0) {
+            LOG__WARN("recorder %s: truncate: %s", filename, strerror(errno));
+        }
+        close(fd);
+        fd = -1;
+        LOG__INFO("recorder %s: %zu bytes", filename, used);
+    }
+}
+
+/**
+ * start a new file, named by the time
+ * @return 0 if ok
+ */
+static int open_file(void) {
+    close_file();
+
+    opened = time(NULL);
+    struct tm t;
+    localtime_r(&opened, &t);
+    char stamp[32];
+    strftime(stamp, sizeof (stamp), "%Y%m%d-%H%M%S", &t);
+
+    // several files within one second get a suffix
+    for (int i = 0; fd < 0 && i < 100; i++) {
+        if (i == 0) {
+            snprintf(filename, sizeof (filename), "%s/mavrpt-%s.tlog", directory, stamp);
+        } else {
+            snprintf(filename, sizeof (filename), "%s/mavrpt-%s-%d.tlog", directory, stamp, i);
+        }
+        fd = open(filename, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0 && errno != EEXIST) {
+            break;
+        }
+    }
+    if (fd < 0) {
+        LOG__ERROR("recorder %s: %s", filename, strerror(errno));
+        return -1;
+    }
+
+    int err = posix_fallocate(fd, 0, file_size);
+    if (err != 0 && ftruncate(fd, file_size) < 0) {
+        LOG__ERROR("recorder %s: allocate %zu bytes: %s", filename, file_size, strerror(err));
+        close(fd);
+        fd = -1;
+        return -1;
+    }
+    map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG__ERROR("recorder %s: mmap: %s", filename, strerror(errno));
+        map = NULL;
+        close(fd);
+        fd = -1;
+        return -1;
+    }
+    used = 0;
+    stats.files++;
+    LOG__INFO("recorder: recording to %s", filename);
+    return 0;
+}
+
+/**
+ * write all frames of the ring
+ */
+static void drain_ring(void) {
+    recorder_slot_t *slot;
+    while ((slot = spsc_front(&ring)) != NULL) {
+        size_t need = 8 + slot->len;
+        bool rotate = !map || used + need > file_size ||
+                (rotate_s > 0 && used > 0 && time(NULL) - opened >= rotate_s);
+        if (rotate && open_file() < 0) {
+            stats.lost++;
+            spsc_pop(&ring);
+            continue;
+        }
+
+        uint8_t *p = map + used;
+        for (int i = 0; i < 8; i++) {
+            p[i] = slot->time_us >> (56 - 8 * i);
+        }
+        memcpy(p + 8, slot->data, slot->len);
+        used += need;
+        stats.frames++;
+        stats.bytes += need;
+        spsc_pop(&ring);
+    }
+}
+
+static void* recorder_thread(void *arg) {
+    struct pollfd pfd = {wake_fd, POLLIN, 0};
+    while (!__atomic_load_n(&thread_stop, __ATOMIC_ACQUIRE)) {
+        drain_ring();
+        if (poll(&pfd, 1, RECORDER_FLUSH_MS) > 0) {
+            uint64_t count;
+            if (read(wake_fd, &count, sizeof (count)) < 0) {
+                // nothing pending
+            }
+        }
+        // rotate by time also while no frames come in
+        if (map && rotate_s > 0 && time(NULL) - opened >= rotate_s) {
+            close_file();
+        }
+    }
+    drain_ring();
+    close_file();
+    return NULL;
+}
+
+/**
+ * start recording into dir. The first file is created with the first frame.
+ * @param dir
+ * @param size bytes per file, 0 = RECORDER_DEFAULT_SIZE
+ * @param rotate_minutes new file after this time, 0 = only by size
+ * @return 0 if ok
+ */
+int recorder_open(const char *dir, size_t size, int rotate_minutes) {
+    strncpy(directory, dir, sizeof (directory) - 1);
+    file_size = size > 0 ? size : RECORDER_DEFAULT_SIZE;
+    rotate_s = rotate_minutes * 60;
+    memset(&stats, 0, sizeof (stats));
+    published = 0;
+    thread_stop = false;
+
+    if (spsc_init(&ring, RECORDER_RING_SLOTS, sizeof (recorder_slot_t)) < 0) {
+        LOG__ERROR("recorder: allocate ring failed");
+        return -1;
+    }
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        LOG__ERROR("recorder: eventfd: %s", strerror(errno));
+        spsc_free(&ring);
+        return -1;
+    }
+
+    // signals are handled by the event loop (signalfd), not by the thread
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&thread, NULL, recorder_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        LOG__ERROR("recorder: create thread failed: %s", strerror(err));
+        close(wake_fd);
+        wake_fd = -1;
+        spsc_free(&ring);
+        return -1;
+    }
+    recorder_active = true;
+    LOG__INFO("recorder: tlogs in %s, %zu bytes per file, new file every %d minutes",
+            directory, file_size, rotate_minutes);
+    return 0;
+}
+
+/**
+ * hand a received frame to the recorder thread, event loop only.
+ * Never blocks: a full ring drops the frame.
+ * @param frame
+ */
+void recorder_write(const mav_frame_t *frame) {
+    recorder_slot_t *slot = spsc_claim(&ring);
+    if (!slot) {
+        stats.dropped++;
+        return;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    slot->time_us = (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    slot->len = frame->len;
+    memcpy(slot->data, frame->data, frame->len);
+    spsc_publish(&ring);
+
+    // the thread looks every RECORDER_FLUSH_MS, wake it before the ring runs full
+    if ((++published & (RECORDER_RING_SLOTS / 4 - 1)) == 0) {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof (one)) < 0) {
+            // the thread reads the counter, it can't overflow
+        }
+    }
+}
+
+/**
+ * write the rest and stop the recorder thread
+ */
+void recorder_close(void) {
+    if (!recorder_active) return;
+    recorder_active = false;
+
+    __atomic_store_n(&thread_stop, true, __ATOMIC_RELEASE);
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof (one)) < 0) {
+        // see recorder_write()
+    }
+    pthread_join(thread, NULL);
+    close(wake_fd);
+    wake_fd = -1;
+    spsc_free(&ring);
+}
+
+void recorder_status(void) {
+    if (!recorder_active) return;
+    LOG__INFO("recorder: %u frames (%llu bytes) in %u files, %u dropped (disk behind), %u lost (no file)",
+            stats.frames, (unsigned long long) stats.bytes, stats.files, stats.dropped, stats.lost);
+}
@@ -0,0 +1,1601 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   relay.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+
+#include "relay.h"
+#include "router.h"
+#include "event.h"
+#include "tcp.h"
+#include "resolver.h"
+#include "convert.h"
+#include "logging.h"
+#include "eventlog.h"
+#include "recorder.h"
+#include "common/mavlink.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define RELAY_EXPIRE_INTERVAL_MS 1000
+#define RELAY_FILTER_MSGIDS      65536
+
+extern volatile sig_atomic_t stop_requested;
+
+static link_t links[RELAY_MAX_LINKS];
+static int link_count = 0;
+static udp_batch_t udp_rx;      // shared, datagrams are processed before the next receive
+static router_t router;
+static dedup_t *dedup;          // NULL = every copy is forwarded
+
+static void on_serial_event(int fd, uint32_t events, void *ctx);
+static void on_serial_notify(int fd, uint32_t events, void *ctx);
+static void on_udp_event(int fd, uint32_t events, void *ctx);
+static void on_tcp_event(int fd, uint32_t events, void *ctx);
+static void on_reconnect_timer(int fd, uint32_t events, void *ctx);
+static void on_serial_reopen(int fd, uint32_t events, void *ctx);
+static void on_serial_event(int fd, uint32_t events, void *ctx);
+static void on_serial_notify(int fd, uint32_t events, void *ctx);
+static void on_expire_timer(int fd, uint32_t events, void *ctx);
+static void on_router_timer(int fd, uint32_t events, void *ctx);
+static void on_pace_timer(int fd, uint32_t events, void *ctx);
+static void on_read_timer(int fd, uint32_t events, void *ctx);
+static void link_flush(link_t *link);
+static void link_output(link_t *link, framebuf_t *fb, const client_key_t *peer);
+static void on_rate_timer(int fd, uint32_t events, void *ctx);
+static void on_fec_timer(int fd, uint32_t events, void *ctx);
+static void relay_flush(void);
+
+/**
+ * prepare the relay
+ * @return 0 if ok
+ */
+int relay_init(void) {
+    link_count = 0;
+    router_init(&router);
+    if (framebuf_init() < 0 ||
+            event_add_timer(RELAY_EXPIRE_INTERVAL_MS, on_router_timer, NULL) < 0) {
+        return -1;
+    }
+    return udp_batch_init(&udp_rx, true);
+}
+
+static link_t* new_link(LinkType type, const char *name) {
+    if (link_count >= RELAY_MAX_LINKS) {
+        LOG__ERROR("too many links, %s not added", name);
+        return NULL;
+    }
+    link_t *link = &links[link_count];
+    memset(link, 0, sizeof (*link));
+    link->id = link_count;
+    link->type = type;
+    link->fd = -1;
+    link->reconnect_fd = -1;
+    link->pace_fd = -1;
+    link->read_fd = -1;
+    link->rate_fd = -1;
+    link->coalesce_fd = -1;
+    link->fec_fd = -1;
+    link->direction = DIRECTION_BOTH;
+    strncpy(link->name, name, sizeof (link->name) - 1);
+    framer_init(&link->framer);
+    return link;
+}
+
+/**
+ * forward only the first copy of a frame which comes over redundant links
+ * @param on
+ */
+void relay_set_dedup(bool on) {
+    if (on && !dedup) {
+        dedup = malloc(sizeof (dedup_t));
+        if (!dedup) {
+            LOG__ERROR("allocate dedup table failed");
+            return;
+        }
+        dedup_init(dedup);
+        LOG__INFO("duplicate frames of redundant links are dropped");
+    } else if (!on) {
+        free(dedup);
+        dedup = NULL;
+    }
+}
+
+/**
+ * add a serial port
+ * @param device
+ * @param baudrate
+ * @param opt tuning of the port, NULL = defaults
+ * @return link or NULL
+ */
+/**
+ * hand an opened tty to the event loop. threaded: the tty belongs to the
+ * reader and writer thread, the event loop only sees their notify eventfd
+ * @param link
+ * @return 0 if ok, the port is closed otherwise
+ */
+static int serial_start(link_t *link) {
+    framer_stats_t stats = link->framer.stats;
+    framer_init(&link->framer);
+    link->framer.stats = stats;
+    if (link->serial.opt.threaded) {
+        if (startSerial(&link->serial, &link->framer) < 0) {
+            closeSerial(&link->serial);
+            return -1;
+        }
+        link->fd = link->serial.notify_fd;
+    } else {
+        link->fd = link->serial.fd;
+    }
+    int added = link->serial.threaded ?
+            event_add(link->fd, EPOLLIN, on_serial_notify, link) :
+            event_add(link->fd, EPOLLIN | EPOLLOUT, on_serial_event, link);
+    if (added < 0) {
+        closeSerial(&link->serial);
+        link->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+link_t* relay_add_serial(const char *device, int baudrate, const serial_opt_t *opt) {
+    link_t *link = new_link(LINK_SERIAL, device);
+    if (!link) return NULL;
+
+    // the scheduler queues hold their frames, a backed up radio must not take them from the other links
+    if (framebuf_reserve(TXSCHED_CLASSES * TXSCHED_QUEUE_LEN) < 0) {
+        return NULL;
+    }
+    if (openSerial(&link->serial, device, baudrate, opt) < 0) {
+        return NULL;
+    }
+    // batched reads: bytes below the batch size are picked up by a timer
+    if (!link->serial.opt.threaded && link->serial.opt.read_batch > 1) {
+        link->read_fd = event_add_timer(link->serial.opt.read_wait_ms, on_read_timer, link);
+    }
+    txsched_init(&link->sched, &link->serial, event_now_ms());
+    flowctl_init(&link->flow);
+    link->pace_fd = event_add_timer(0, on_pace_timer, link);
+    link->reconnect_fd = event_add_timer(0, on_serial_reopen, link);
+    if (link->pace_fd < 0 || link->reconnect_fd < 0 ||
+            (link->read_fd < 0 && !link->serial.opt.threaded && link->serial.opt.read_batch > 1) ||
+            serial_start(link) < 0) {
+        if (link->pace_fd >= 0) event_remove(link->pace_fd);
+        if (link->reconnect_fd >= 0) event_remove(link->reconnect_fd);
+        if (link->read_fd >= 0) event_remove(link->read_fd);
+        closeSerial(&link->serial);
+        return NULL;
+    }
+    link_count++;
+    LOG__INFO("link %d: serial %s, %d baud", link->id, device, link->serial.baudrate);
+    return link;
+}
+
+/**
+ * address of an udp client link resolved or changed: (re)connect the socket
+ */
+static void on_udp_resolved(void *ctx, const struct sockaddr *addr, socklen_t addrlen) {
+    link_t *link = ctx;
+    sa_family_t family = link->addr.ss_family;
+
+    memcpy(&link->addr, addr, addrlen);
+    link->addrlen = addrlen;
+
+    // same family: connect() just changes the peer of the socket
+    if (link->fd >= 0) {
+        if (addr->sa_family == family && connect(link->fd, addr, addrlen) == 0) {
+            return;
+        }
+        link_flush(link);
+        event_remove(link->fd);
+        close(link->fd);
+        link->fd = -1;
+    }
+
+    link->fd = udp_connect(addr, addrlen);
+    if (link->fd < 0) {
+        LOG__ERROR("udp socket %s: %s", link->name, strerror(errno));
+        return;
+    }
+    if (event_add(link->fd, EPOLLIN, on_udp_event, link) < 0) {
+        close(link->fd);
+        link->fd = -1;
+    }
+}
+
+/**
+ * add an udp endpoint which sends to one remote address. Until a host name
+ * is resolved the frames for the link are dropped.
+ * @param host name, IPv4 or IPv6 address
+ * @param port
+ * @return link or NULL
+ */
+link_t* relay_add_udp_client(const char *host, int port) {
+    char name[64];
+    snprintf(name, sizeof (name), "%s:%d", host, port);
+    link_t *link = new_link(LINK_UDP_CLIENT, name);
+    if (!link) return NULL;
+
+    strncpy(link->server, host, sizeof (link->server) - 1);
+    link->port = port;
+    if (framebuf_reserve(RELAY_TX_HELD_MAX) < 0 || udp_batch_init(&link->tx, false) < 0) {
+        return NULL;
+    }
+    if (resolver_add(host, port, SOCK_DGRAM, on_udp_resolved, link) < 0) {
+        udp_batch_free(&link->tx);
+        return NULL;
+    }
+    link_count++;
+    LOG__INFO("link %d: udp to %s", link->id, name);
+    return link;
+}
+
+/**
+ * add an udp server port, every source address is a client session
+ * @param port
+ * @return link or NULL
+ */
+link_t* relay_add_udp_server(int port) {
+    char name[64];
+    snprintf(name, sizeof (name), "server:%d", port);
+    link_t *link = new_link(LINK_UDP_SERVER, name);
+    if (!link) return NULL;
+
+    link->clients = malloc(sizeof (client_table_t));
+    if (!link->clients) {
+        LOG__ERROR("allocate client table failed");
+        return NULL;
+    }
+    clients_init(link->clients);
+
+    link->fd = setup_udp_server_socket(port);
+    if (link->fd < 0) {
+        free(link->clients);
+        return NULL;
+    }
+    if (framebuf_reserve(RELAY_TX_HELD_MAX) < 0 || udp_batch_init(&link->tx, false) < 0 ||
+            event_add(link->fd, EPOLLIN, on_udp_event, link) < 0 ||
+            event_add_timer(RELAY_EXPIRE_INTERVAL_MS, on_expire_timer, link) < 0) {
+        close(link->fd);
+        free(link->clients);
+        return NULL;
+    }
+    link_count++;
+    LOG__INFO("link %d: udp server on port %d", link->id, port);
+    return link;
+}
+
+static int tcp_start_connect(link_t *link) {
+    link->connected = false;
+    link->fd = tcp_connect((struct sockaddr*) &link->addr, link->addrlen);
+    if (link->fd < 0) {
+        LOG__WARN("tcp %s: connect failed: %s", link->name, strerror(errno));
+        return -1;
+    }
+    if (event_add(link->fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP, on_tcp_event, link) < 0) {
+        close(link->fd);
+        link->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * address of a tcp link resolved or changed. A new address is used with the
+ * next connect, a running connection is kept.
+ */
+static void on_tcp_resolved(void *ctx, const struct sockaddr *addr, socklen_t addrlen) {
+    link_t *link = ctx;
+
+    memcpy(&link->addr, addr, addrlen);
+    link->addrlen = addrlen;
+    if (link->fd < 0 && tcp_start_connect(link) < 0) {
+        event_timer_set(link->reconnect_fd, RELAY_RECONNECT_MS, 0);
+    }
+}
+
+/**
+ * add a tcp endpoint, the connection is kept up by reconnecting
+ * @param host name, IPv4 or IPv6 address
+ * @param port
+ * @return link or NULL
+ */
+link_t* relay_add_tcp_client(const char *host, int port) {
+    char name[64];
+    snprintf(name, sizeof (name), "tcp:%s:%d", host, port);
+    link_t *link = new_link(LINK_TCP_CLIENT, name);
+    if (!link) return NULL;
+
+    strncpy(link->server, host, sizeof (link->server) - 1);
+    link->port = port;
+    if (ringbuf_init(&link->stream_tx, RELAY_STREAM_BUFFER_SIZE) < 0) {
+        return NULL;
+    }
+    link->reconnect_fd = event_add_timer(0, on_reconnect_timer, link);
+    if (link->reconnect_fd < 0) {
+        ringbuf_free(&link->stream_tx);
+        return NULL;
+    }
+    if (resolver_add(host, port, SOCK_STREAM, on_tcp_resolved, link) < 0) {
+        event_remove(link->reconnect_fd);
+        ringbuf_free(&link->stream_tx);
+        return NULL;
+    }
+    link_count++;
+    LOG__INFO("link %d: %s", link->id, name);
+    return link;
+}
+
+/**
+ * build the msgid filter bitmap of a link
+ */
+static int set_filter(link_t *link, const endpoint_opt_t *ep) {
+    if (ep->filter_count == 0) {
+        return 0;
+    }
+    link->filter = calloc(RELAY_FILTER_MSGIDS / 8, 1);
+    if (!link->filter) {
+        return -1;
+    }
+    for (int i = 0; i < ep->filter_count; i++) {
+        if (ep->filter[i] < RELAY_FILTER_MSGIDS) {
+            link->filter[ep->filter[i] >> 3] |= 1 << (ep->filter[i] & 7);
+        }
+    }
+    link->filter_block = ep->filter_block;
+    return 0;
+}
+
+/**
+ * per msgid rate caps of a link
+ */
+static int set_rates(link_t *link, const endpoint_opt_t *ep) {
+    if (ep->rate_count == 0) {
+        return 0;
+    }
+    link->rates = ratecap_create();
+    if (!link->rates) {
+        return -1;
+    }
+    for (int i = 0; i < ep->rate_count; i++) {
+        if (ratecap_add(link->rates, ep->rate_msgid[i], ep->rate_hz[i]) < 0) {
+            LOG__WARN("link %d: rate cap for msgid %u ignored", link->id, ep->rate_msgid[i]);
+        }
+    }
+    // one held frame per source of a capped msgid
+    if (framebuf_reserve(RATECAP_SOURCES) < 0) {
+        return -1;
+    }
+    link->rate_fd = event_add_timer(0, on_rate_timer, link);
+    return link->rate_fd < 0 ? -1 : 0;
+}
+
+/**
+ * add a configured endpoint
+ * @param ep
+ * @return link or NULL
+ */
+link_t* relay_add_endpoint(const endpoint_opt_t *ep) {
+    link_t *link = NULL;
+
+    switch (ep->type) {
+        case ENDPOINT_SERIAL:
+            link = relay_add_serial(ep->device, ep->baudrate, &ep->serial);
+            break;
+        case ENDPOINT_UDP:
+            link = relay_add_udp_client(ep->server, ep->port);
+            break;
+        case ENDPOINT_UDP_SERVER:
+            link = relay_add_udp_server(ep->port);
+            break;
+        case ENDPOINT_TCP:
+            link = relay_add_tcp_client(ep->server, ep->port);
+            break;
+    }
+    if (!link) {
+        return NULL;
+    }
+    link->direction = ep->direction;
+    if (set_filter(link, ep) < 0) {
+        LOG__ERROR("link %d: allocate filter failed", link->id);
+        return NULL;
+    }
+    if (set_rates(link, ep) < 0) {
+        LOG__ERROR("link %d: allocate rate caps failed", link->id);
+        return NULL;
+    }
+    link->version = ep->version;
+    if (ep->mtu > 0 && relay_set_coalesce(link, ep->mtu, ep->coalesce_ms) < 0) {
+        LOG__ERROR("link %d: coalescing not possible", link->id);
+        return NULL;
+    }
+    if (ep->compress && relay_set_compress(link) < 0) {
+        LOG__ERROR("link %d: tunnel codec not possible", link->id);
+        return NULL;
+    }
+    if (ep->fec > 0 && relay_set_fec(link, ep->fec, ep->fec_ms) < 0) {
+        LOG__ERROR("link %d: FEC not possible", link->id);
+        return NULL;
+    }
+    return link;
+}
+
+/**
+ * send the parity datagrams of the closed FEC groups
+ */
+static void send_parity(link_t *link) {
+    for (int i = 0; i < link->parity_count; i++) {
+        tunnel_t *t = link->parity_peer[i];
+        sendto(link->fd, link->parity[i], link->parity_len[i], MSG_DONTWAIT,
+                t->addrlen ? (struct sockaddr*) &t->addr : NULL, t->addrlen);
+    }
+    link->parity_count = 0;
+}
+
+static void queue_parity(link_t *link, tunnel_t *t) {
+    if (link->parity_count >= UDP_BATCH_SIZE) {
+        send_parity(link);
+    }
+    int n = link->parity_count++;
+    link->parity_len[n] = fec_parity(&t->fec, link->parity[n]);
+    link->parity_peer[n] = t;
+}
+
+/**
+ * put datagram i of the batch into the FEC group of its peer. A full group
+ * is closed, the first datagram of a group starts the window.
+ */
+static void fec_add(link_t *link, tunnel_t *t, int i) {
+    struct msghdr *hdr = &link->tx.msgs[i].msg_hdr;
+    const uint8_t *header = fec_encode(&t->fec, i, hdr->msg_iov, hdr->msg_iovlen, event_now_ms());
+    udp_batch_prepend(&link->tx, i, header, FEC_HEADER_LEN);
+    if (fec_group_full(&t->fec)) {
+        queue_parity(link, t);
+    } else if (!link->fec_armed) {
+        event_timer_set(link->fec_fd, link->fec_ms, 0);
+        link->fec_armed = true;
+    }
+}
+
+/**
+ * send the batch and release the frames of its datagrams. The parity of
+ * the groups closed by the batch goes out after it.
+ */
+static void send_batch(link_t *link) {
+    int count = link->tx.count;
+    int frames[UDP_BATCH_SIZE];
+
+    for (int i = 0; i < count; i++) {
+        frames[i] = link->tx.msgs[i].msg_hdr.msg_iovlen;
+        tunnel_t *t = link->tx_peer[i];
+        // a server session gets FEC once it sends FEC itself
+        if (link->fec_k > 0 && t && (link->type == LINK_UDP_CLIENT || t->fec.seen)) {
+            fec_add(link, t, i);
+        }
+    }
+    udp_send_batch(link->fd, &link->tx);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < frames[i]; j++) {
+            framebuf_t *fb = link->tx_ref[i * UDP_DATAGRAM_FRAMES + j];
+            if (fb) framebuf_unref(fb);
+        }
+    }
+    link->tx_held = 0;
+    link->tx_last = NULL;
+    send_parity(link);
+}
+
+/**
+ * send the queued datagrams of an udp link and release the frames.
+ * The codec datagrams are added last, their buffers are reused right after.
+ */
+static void link_flush(link_t *link) {
+    for (int i = 0; i < link->tunnel_queued; i++) {
+        tunnel_t *t = link->tunnel_queue[i];
+        const struct sockaddr *addr = t->addrlen ? (struct sockaddr*) &t->addr : NULL;
+        int n = udp_batch_add(&link->tx, t->out, t->out_len, addr, t->addrlen, 0);
+        if (n < 0) {
+            send_batch(link);
+            n = udp_batch_add(&link->tx, t->out, t->out_len, addr, t->addrlen, 0);
+        }
+        link->tx_ref[n] = NULL;
+        link->tx_peer[n / UDP_DATAGRAM_FRAMES] = t;
+    }
+    send_batch(link);
+    for (int i = 0; i < link->tunnel_queued; i++) {
+        tunnel_sent(link->tunnel_queue[i]);
+    }
+    link->tunnel_queued = 0;
+}
+
+static inline bool link_pending(const link_t *link) {
+    return link->tx.count > 0 || link->tunnel_queued > 0;
+}
+
+/**
+ * space for frames in a datagram of mtu bytes, the FEC parity header is
+ * reserved
+ */
+static inline int link_mtu(const link_t *link, int mtu) {
+    return (mtu > 0 && link->fec_k > 0) ? mtu - FEC_PARITY_HEADER : mtu;
+}
+
+/**
+ * the first datagram queued on a coalescing link starts the deadline
+ */
+static inline void start_deadline(link_t *link, bool was_pending) {
+    if (link->coalesce_fd >= 0 && !was_pending) {
+        event_timer_set(link->coalesce_fd, link->coalesce_ms, 0);
+    }
+}
+
+/**
+ * send queued datagrams of all udp links. Links which coalesce frames
+ * are sent by their deadline timer or when a datagram is full.
+ */
+static void relay_flush(void) {
+    for (int i = 0; i < link_count; i++) {
+        link_t *link = &links[i];
+        if ((link->type == LINK_UDP_CLIENT || link->type == LINK_UDP_SERVER) &&
+                link_pending(link) && link->coalesce_fd < 0) {
+            link_flush(link);
+        }
+    }
+}
+
+/**
+ * queue a raw frame
+ * @param link
+ * @param fb
+ * @param addr destination on a server link, NULL on a connected socket
+ * @param addrlen
+ * @param peer tunnel state of the destination, NULL = none
+ */
+static void queue_datagram(link_t *link, framebuf_t *fb, const struct sockaddr *addr, socklen_t addrlen, tunnel_t *peer) {
+    bool was_pending = link_pending(link);
+    int mtu = link_mtu(link, link->mtu);
+    int n = udp_batch_add(&link->tx, fb->frame.data, fb->frame.len, addr, addrlen, mtu);
+    if (n < 0) {
+        // batch or datagram full
+        link_flush(link);
+        was_pending = false;
+        n = udp_batch_add(&link->tx, fb->frame.data, fb->frame.len, addr, addrlen, mtu);
+    }
+    link->tx_ref[n] = framebuf_ref(fb);
+    link->tx_peer[n / UDP_DATAGRAM_FRAMES] = peer;
+    if (fb != link->tx_last && ++link->tx_held >= RELAY_TX_HELD_MAX) {
+        // don't pin the shared pool, the other links need buffers too
+        link_flush(link);
+        return;
+    }
+    link->tx_last = fb;
+    start_deadline(link, was_pending);
+}
+
+/**
+ * send a frame through the codec of a peer. Until the peer has agreed on a
+ * version the frames go out raw and a client link offers the codec from
+ * time to time.
+ * @return true if the frame is in the codec datagram of the peer
+ */
+static bool tunnel_send(link_t *link, tunnel_t *t, const mav_frame_t *frame) {
+    if (t->version == 0) {
+        uint64_t now = event_now_ms();
+        if (link->type == LINK_UDP_CLIENT && (t->hello_ms == 0 || now - t->hello_ms >= TUNNEL_HELLO_MS)) {
+            uint8_t hello[TUNNEL_CONTROL_LEN];
+            send(link->fd, hello, tunnel_hello(hello), 0);
+            t->hello_ms = now;
+        }
+        return false;
+    }
+
+    int mtu = link_mtu(link, link->mtu > 0 ? link->mtu : TUNNEL_MTU);
+    bool was_pending = link_pending(link);
+    if (tunnel_encode(t, frame, mtu) < 0) {
+        link_flush(link);
+        was_pending = false;
+        tunnel_encode(t, frame, mtu);
+    }
+    if (!t->queued) {
+        if (link->tunnel_queued >= UDP_BATCH_SIZE) {
+            link_flush(link);
+        }
+        link->tunnel_queue[link->tunnel_queued++] = t;
+        t->queued = true;
+    }
+    start_deadline(link, was_pending);
+    return true;
+}
+
+static void on_coalesce_timer(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    event_timer_read(fd);
+    if (link_pending(link)) {
+        link_flush(link);
+    }
+}
+
+/**
+ * pack frames to the same destination into datagrams of up to mtu bytes.
+ * A datagram is sent when it is full, at the latest deadline_ms after its
+ * first frame.
+ * @param link udp link
+ * @param mtu max. datagram size, 0 = one frame per datagram
+ * @param deadline_ms 0 = RELAY_COALESCE_MS
+ * @return 0 if ok
+ */
+int relay_set_coalesce(link_t *link, int mtu, int deadline_ms) {
+    if (link->type != LINK_UDP_CLIENT && link->type != LINK_UDP_SERVER) {
+        return -1;
+    }
+    if (mtu > UDP_DATAGRAM_SIZE) {
+        mtu = UDP_DATAGRAM_SIZE;    // receive buffer of the other side
+    }
+    link->mtu = mtu;
+    if (mtu <= 0) {
+        return 0;
+    }
+    if (deadline_ms <= 0) {
+        deadline_ms = RELAY_COALESCE_MS;
+    }
+    link->coalesce_ms = deadline_ms;
+    link->coalesce_fd = event_add_timer(0, on_coalesce_timer, link);
+    if (link->coalesce_fd < 0) {
+        return -1;
+    }
+    LOG__INFO("link %d %s: coalesce frames up to %d bytes, deadline %d ms", link->id, link->name, mtu, deadline_ms);
+    return 0;
+}
+
+/**
+ * tunnel state of a peer, FEC set up as configured for the link
+ */
+static tunnel_t* new_tunnel(link_t *link) {
+    tunnel_t *t = malloc(sizeof (tunnel_t));
+    if (t) {
+        tunnel_init(t, &link->tunnel_stats);
+        fec_init(&t->fec, link->fec_k, link->fec_ms, &link->fec_stats);
+    }
+    return t;
+}
+
+/**
+ * compress the frames on the tunnel between mavrptclient and mavrptserver.
+ * Both sides must enable it, otherwise the frames stay raw.
+ * @param link udp link
+ * @return 0 if ok
+ */
+int relay_set_compress(link_t *link) {
+    if (link->type != LINK_UDP_CLIENT && link->type != LINK_UDP_SERVER) {
+        return -1;
+    }
+    if (link->type == LINK_UDP_CLIENT && !link->tunnel && !(link->tunnel = new_tunnel(link))) {
+        return -1;
+    }
+    link->compress = true;
+    LOG__INFO("link %d %s: tunnel codec version %d", link->id, link->name, TUNNEL_VERSION);
+    return 0;
+}
+
+/**
+ * send a XOR parity datagram after every k datagrams, at the latest
+ * window_ms after the first one. A server link sends FEC only to the
+ * clients which send FEC themselves.
+ * @param link udp link
+ * @param k datagrams per parity, 2..FEC_MAX_GROUP
+ * @param window_ms 0 = FEC_WINDOW_MS
+ * @return 0 if ok
+ */
+int relay_set_fec(link_t *link, int k, int window_ms) {
+    if ((link->type != LINK_UDP_CLIENT && link->type != LINK_UDP_SERVER) || k < 2 || k > FEC_MAX_GROUP) {
+        return -1;
+    }
+    link->fec_k = k;
+    link->fec_ms = (window_ms > 0) ? window_ms : FEC_WINDOW_MS;
+    link->parity = malloc(UDP_BATCH_SIZE * sizeof (*link->parity));
+    if (!link->parity) {
+        return -1;
+    }
+    link->fec_fd = event_add_timer(0, on_fec_timer, link);
+    if (link->fec_fd < 0) {
+        return -1;
+    }
+    if (link->type == LINK_UDP_CLIENT) {
+        if (!link->tunnel && !(link->tunnel = new_tunnel(link))) {
+            return -1;
+        }
+        fec_init(&link->tunnel->fec, k, link->fec_ms, &link->fec_stats);
+    }
+    LOG__INFO("link %d %s: FEC, one parity per %d datagrams, window %d ms", link->id, link->name, k, link->fec_ms);
+    return 0;
+}
+
+/**
+ * write queued bytes to the tcp socket until it would block
+ */
+static void stream_flush(link_t *link) {
+    const uint8_t *data;
+    size_t len;
+
+    while (link->connected && (len = ringbuf_peek(&link->stream_tx, &data)) > 0) {
+        ssize_t n = send(link->fd, data, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            ringbuf_consume(&link->stream_tx, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+}
+
+/**
+ * pace a serial link to the share of the line rate the radio allows
+ */
+static void apply_flow(link_t *link) {
+    uint32_t line_rate = link->serial.baudrate / link->serial.char_bits;
+    pacer_set_rate(&link->sched.pacer, line_rate * link->flow.percent / 100);
+}
+
+/**
+ * move scheduled frames to the serial port. If the pacer holds the next
+ * frame back, the pace timer is armed for it.
+ */
+static void serial_drain(link_t *link) {
+    if (link->fd < 0) {
+        return;     // port lost, see serial_disconnect()
+    }
+    for (;;) {
+        int wait_ms = txsched_drain(&link->sched, &link->serial, event_now_ms());
+        if (wait_ms > 0 && !link->pace_armed) {
+            event_timer_set(link->pace_fd, wait_ms, 0);
+            link->pace_armed = true;
+        }
+        // threaded: frames wait for the writer thread, it signals the drained
+        // tx ring instead of EPOLLOUT
+        if (wait_ms > 0 || !link->serial.threaded || link->sched.bytes == 0 ||
+                waitSerial(&link->serial)) {
+            break;
+        }
+    }
+}
+
+/**
+ * record a frame which is not sent in the event log
+ */
+static inline void log_drop(const link_t *link, const mav_frame_t *frame, EventlogDrop reason) {
+    EVENTLOG(EVENTLOG_FRAME_DROP, link->id, frame->msgid, frame->sysid, frame->compid, reason);
+}
+
+static inline bool filter_pass(const link_t *link, uint32_t msgid) {
+    if (!link->filter) {
+        return true;
+    }
+    bool listed = msgid < RELAY_FILTER_MSGIDS && (link->filter[msgid >> 3] & (1 << (msgid & 7)));
+    return link->filter_block ? !listed : listed;
+}
+
+/**
+ * arm the rate timer for the next held frame, if it is earlier than the
+ * time the timer is armed for
+ */
+static void arm_rate_timer(link_t *link) {
+    uint64_t next = ratecap_next_ms(link->rates);
+    if (next == 0 || (link->rate_due != 0 && link->rate_due <= next)) {
+        return;
+    }
+    uint64_t now = event_now_ms();
+    event_timer_set(link->rate_fd, next > now ? (int) (next - now) : 1, 0);
+    link->rate_due = next;
+}
+
+/**
+ * send a frame on a link. Frames for udp links are queued until relay_flush().
+ * @param link
+ * @param fb
+ * @param peer session on a server link, NULL sends to all sessions
+ */
+static void link_send(link_t *link, framebuf_t *fb, const client_key_t *peer) {
+    if (link->direction == DIRECTION_IN) {
+        return;
+    }
+    if (!filter_pass(link, fb->frame.msgid)) {
+        link->filtered++;
+        log_drop(link, &fb->frame, EVENTLOG_DROP_FILTERED);
+        return;
+    }
+    if (link->rates && !ratecap_admit(link->rates, fb, peer, event_now_ms())) {
+        arm_rate_timer(link);
+        return;
+    }
+    link_output(link, fb, peer);
+}
+
+/**
+ * output a frame which passed the checks of the link
+ */
+static void link_output(link_t *link, framebuf_t *fb, const client_key_t *peer) {
+    const mav_frame_t *frame = &fb->frame;
+
+    switch (link->type) {
+        case LINK_SERIAL:
+        {
+            if (link->fd < 0) {
+                link->tx_dropped++;     // port lost, reopened by a timer
+                log_drop(link, frame, EVENTLOG_DROP_LINK_DOWN);
+                return;
+            }
+            uint64_t now = event_now_ms();
+            if (flowctl_expire(&link->flow, now)) {
+                apply_flow(link);
+            }
+            // the radio is filling up: thin out the telemetry, keep control and transfers
+            if (txsched_classify(frame->msgid) == TXSCHED_TELEMETRY && flowctl_downsample(&link->flow)) {
+                log_drop(link, frame, EVENTLOG_DROP_DOWNSAMPLED);
+                return;
+            }
+            txsched_enqueue(&link->sched, fb, now);
+            serial_drain(link);
+        }
+            break;
+
+        case LINK_UDP_CLIENT:
+            if (link->fd < 0) {
+                link->tx_dropped++;     // not resolved
+                log_drop(link, frame, EVENTLOG_DROP_UNRESOLVED);
+                return;
+            }
+            if (!link->compress || !tunnel_send(link, link->tunnel, frame)) {
+                queue_datagram(link, fb, NULL, 0, link->tunnel);
+            }
+            break;
+
+        case LINK_UDP_SERVER:
+        {
+            client_table_t *table = link->clients;
+            if (peer) {
+                client_t *client = clients_lookup(table, peer);
+                tunnel_t *t = client ? client->state : NULL;
+                if (!t || !link->compress || !tunnel_send(link, t, frame)) {
+                    struct sockaddr_storage sa;
+                    socklen_t salen = client_key_to_sockaddr(peer, &sa);
+                    queue_datagram(link, fb, (struct sockaddr*) &sa, salen, t);
+                }
+                if (client) client->tx_frames++;
+                break;
+            }
+            // the entries with sysid 0 are the sessions, one per source address
+            for (int i = 0; i < table->count; i++) {
+                client_t *client = &table->entries[i];
+                if (client->key.sysid != 0) continue;
+
+                tunnel_t *t = client->state;
+                if (!t || !link->compress || !tunnel_send(link, t, frame)) {
+                    struct sockaddr_storage sa;
+                    socklen_t salen = client_key_to_sockaddr(&client->key, &sa);
+                    queue_datagram(link, fb, (struct sockaddr*) &sa, salen, t);
+                }
+                client->tx_frames++;
+            }
+        }
+            break;
+
+        case LINK_TCP_CLIENT:
+            if (!link->connected ||
+                    ringbuf_used(&link->stream_tx) + frame->len > RELAY_STREAM_HIGH_WATER) {
+                link->tx_dropped++;
+                log_drop(link, frame, EVENTLOG_DROP_STREAM_FULL);
+                return;
+            }
+            ringbuf_write(&link->stream_tx, frame->data, frame->len);
+            stream_flush(link);
+            break;
+    }
+    link->tx_frames++;
+    EVENTLOG(EVENTLOG_FRAME_TX, link->id, frame->msgid, frame->sysid, frame->compid, frame->seq, frame->len);
+}
+
+/**
+ * send a frame in the mavlink version of the link
+ */
+static void forward_to(link_t *link, framebuf_t *fb, const client_key_t *peer,
+        framebuf_t **variant, bool *converted) {
+    MavVersion version = link->version;
+    if (version != MAVVERSION_KEEP) {
+        if (!converted[version]) {
+            uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+            mav_frame_t frame;
+            int n = convert_frame(&fb->frame, version, buffer, &frame);
+            if (n == 0) {
+                variant[version] = framebuf_ref(fb);
+            } else if (n > 0) {
+                variant[version] = framebuf_get(&frame);
+            }
+            converted[version] = true;
+        }
+        fb = variant[version];
+        if (!fb) {
+            return;     // no representation in this version
+        }
+    }
+    link_send(link, fb, peer);
+}
+
+static void release_variants(framebuf_t *fb, framebuf_t **variant) {
+    for (int v = 0; v <= MAVVERSION_V2; v++) {
+        if (variant[v]) framebuf_unref(variant[v]);
+    }
+    framebuf_unref(fb);
+}
+
+/**
+ * count loss and copies of a received frame per link and per session
+ * @return true for the first copy of the frame
+ */
+static bool dedup_pass(link_t *src, const mav_frame_t *frame, const client_key_t *peer) {
+    client_t *session = peer ? clients_lookup(src->clients, peer) : NULL;
+    uint32_t tag = 0;
+
+    if (peer) {
+        // FNV-1a of the address, sessions of a server link count separately
+        tag = 2166136261u;
+        for (int i = 0; i < 16; i++) tag = (tag ^ peer->addr[i]) * 16777619u;
+        tag = (tag ^ peer->port) * 16777619u;
+    }
+    int lost = dedup_count_seq(&src->dedup, frame, tag);
+    bool first = dedup_check(dedup, frame);
+    if (first) {
+        src->dedup.first++;
+    } else {
+        src->dedup.duplicates++;
+        log_drop(src, frame, EVENTLOG_DROP_DUPLICATE);
+    }
+    if (session) {
+        session->lost += lost;
+        if (first) session->first++;
+        else session->duplicates++;
+    }
+    return first;
+}
+
+/**
+ * forward a frame. The source is learned from the first copy of a frame.
+ * Frames with a known target system go only to the link(s) of the target,
+ * everything else goes to all other links. The frame is copied once into a shared buffer
+ * for all outputs.
+ *
+ * @param src
+ * @param frame
+ * @param peer session on a server link, NULL otherwise
+ */
+static void relay_forward(link_t *src, const mav_frame_t *frame, const client_key_t *peer) {
+    uint8_t target_system, target_component;
+    const route_t *routes[ROUTER_MAX_TARGETS];
+    int n = 0;
+
+    src->rx_frames++;
+    EVENTLOG(EVENTLOG_FRAME_RX, src->id, frame->msgid, frame->sysid, frame->compid, frame->seq, frame->len);
+    if (recorder_active) {
+        recorder_write(frame);
+    }
+    if (src->direction == DIRECTION_OUT) {
+        return;
+    }
+    if (src->type == LINK_SERIAL && frame->msgid == MAVLINK_MSG_ID_RADIO_STATUS &&
+            flowctl_radio_status(&src->flow, frame, event_now_ms())) {
+        apply_flow(src);
+        EVENTLOG(EVENTLOG_RADIO_STATUS, src->id, src->flow.txbuf, src->flow.percent);
+    }
+    if (dedup && !dedup_pass(src, frame, peer)) {
+        return;
+    }
+    // only the first copy, otherwise the route jumps between redundant links
+    router_learn(&router, frame, src->id, peer, event_now_ms());
+
+    framebuf_t *fb = framebuf_get(frame);
+    if (!fb) {
+        return;
+    }
+    // converted copies for links with another mavlink version, made on first use
+    framebuf_t *variant[MAVVERSION_V2 + 1] = {NULL};
+    bool converted[MAVVERSION_V2 + 1] = {false};
+
+    if (router_get_target(frame, &target_system, &target_component) && target_system != 0) {
+        n = router_find(&router, target_system, target_component, routes, ROUTER_MAX_TARGETS);
+    }
+
+    if (n == 0) {
+        // broadcast or unknown target
+        for (int i = 0; i < link_count; i++) {
+            if (&links[i] != src) {
+                forward_to(&links[i], fb, NULL, variant, converted);
+            }
+        }
+        release_variants(fb, variant);
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        const route_t *route = routes[i];
+        link_t *link = &links[route->link];
+        bool server = (link->type == LINK_UDP_SERVER);
+
+        // never back to where it came from, but to another session of a server link
+        if (link == src && (!server || !peer || memcmp(&route->peer, peer, sizeof (*peer)) == 0)) {
+            continue;
+        }
+        // components of one system usually share a link, send only once
+        bool sent = false;
+        for (int j = 0; j < i && !sent; j++) {
+            sent = routes[j]->link == route->link &&
+                    (!server || memcmp(&routes[j]->peer, &route->peer, sizeof (route->peer)) == 0);
+        }
+        if (!sent) {
+            forward_to(link, fb, server ? &route->peer : NULL, variant, converted);
+        }
+    }
+    release_variants(fb, variant);
+}
+
+/**
+ * read a stream (serial port, tcp) until EAGAIN and forward complete frames
+ * @param link
+ * @return 0 at EAGAIN, -1 on end of stream or error
+ */
+static int read_stream(link_t *link) {
+    mav_frame_t frame;
+    int ret = 0;
+
+    for (;;) {
+        // read directly into the framer, only complete frames are forwarded
+        int space;
+        uint8_t *wp = framer_write_ptr(&link->framer, &space);
+        ssize_t len;
+        if (link->type == LINK_SERIAL) {
+            len = readSerial(&link->serial, wp, space);
+        } else {
+            len = read(link->fd, wp, space);
+        }
+        LOG__TRACE("read %d bytes from %s...", len, link->name);
+        if (len <= 0) {
+            if (len == 0 || (errno != EAGAIN && errno != EINTR)) {
+                LOG__ERROR("read %s: %s", link->name, len == 0 ? "end of stream" : strerror(errno));
+                ret = -1;
+            }
+            break;
+        }
+        framer_commit(&link->framer, len);
+        while (framer_next(&link->framer, &frame)) {
+            relay_forward(link, &frame, NULL);
+        }
+    }
+    relay_flush();
+    return ret;
+}
+
+/**
+ * the tty is gone (USB radio unplugged): close it and open it again from a
+ * timer, the other links keep running. Frames for the port are dropped
+ * meanwhile.
+ */
+static void serial_disconnect(link_t *link) {
+    LOG__WARN("serial port %s: lost, reopen every %d ms", link->name, RELAY_RECONNECT_MS);
+    EVENTLOG(EVENTLOG_LINK_DOWN, link->id, 0);
+    event_remove(link->fd);
+    closeSerial(&link->serial);
+    link->fd = -1;
+    txsched_clear(&link->sched);
+    if (link->pace_armed) {
+        event_timer_set(link->pace_fd, 0, 0);
+        link->pace_armed = false;
+    }
+    event_timer_set(link->reconnect_fd, RELAY_RECONNECT_MS, 0);
+}
+
+static void on_serial_reopen(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    event_timer_read(fd);
+
+    // openSerial() starts the port from scratch, the statistics go on
+    serial_stats_t stats = link->serial.stats;
+    serial_opt_t opt = link->serial.opt;
+    if (openSerial(&link->serial, link->name, link->serial.baudrate, &opt) < 0) {
+        event_timer_set(link->reconnect_fd, RELAY_RECONNECT_MS, 0);
+        return;
+    }
+    link->serial.stats = stats;
+    if (serial_start(link) < 0) {
+        event_timer_set(link->reconnect_fd, RELAY_RECONNECT_MS, 0);
+        return;
+    }
+    LOG__INFO("serial port %s: reopened", link->name);
+    EVENTLOG(EVENTLOG_LINK_UP, link->id, 0);
+}
+
+/**
+ * serial port is readable: read until EAGAIN and forward complete frames.
+ * serial port is writable: continue writing the tx queue
+ */
+static void on_serial_event(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        LOG__ERROR("serial port %s: hangup or error", link->name);
+        serial_disconnect(link);
+        return;
+    }
+
+    if (events & EPOLLOUT) {
+        flushSerial(&link->serial);
+        serial_drain(link);
+    }
+    if ((events & EPOLLIN) && read_stream(link) < 0) {
+        serial_disconnect(link);
+    }
+}
+
+/**
+ * threaded serial port: frames from the reader thread, the writer thread has
+ * drained its ring or one of them lost the port
+ */
+static void on_serial_notify(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    uint64_t count;
+    if (read(fd, &count, sizeof (count)) < 0) {
+        // nothing pending
+    }
+
+    if (failedSerial(&link->serial)) {
+        LOG__ERROR("serial port %s: lost by the reader or writer thread", link->name);
+        serial_disconnect(link);
+        return;
+    }
+
+    const mav_frame_t *frame;
+    while ((frame = receiveSerial(&link->serial)) != NULL) {
+        relay_forward(link, frame, NULL);
+        releaseSerial(&link->serial);
+    }
+    relay_flush();
+    serial_drain(link);
+}
+
+static void tcp_disconnect(link_t *link) {
+    LOG__WARN("tcp %s: disconnected, reconnect in %d ms", link->name, RELAY_RECONNECT_MS);
+    EVENTLOG(EVENTLOG_LINK_DOWN, link->id, 0);
+    event_remove(link->fd);
+    close(link->fd);
+    link->fd = -1;
+    link->connected = false;
+    framer_init(&link->framer);
+    ringbuf_consume(&link->stream_tx, ringbuf_used(&link->stream_tx));
+    event_timer_set(link->reconnect_fd, RELAY_RECONNECT_MS, 0);
+}
+
+/**
+ * tcp connection events: connect result, readable, writable, hangup
+ */
+static void on_tcp_event(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+
+    if (!link->connected && (events & EPOLLOUT)) {
+        int err = tcp_connect_result(fd);
+        if (err != 0) {
+            LOG__WARN("tcp %s: connect failed: %s", link->name, strerror(err));
+            tcp_disconnect(link);
+            return;
+        }
+        link->connected = true;
+        LOG__INFO("tcp %s: connected", link->name);
+        EVENTLOG(EVENTLOG_LINK_UP, link->id, 0);
+    }
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        tcp_disconnect(link);
+        return;
+    }
+    if (events & EPOLLOUT) {
+        stream_flush(link);
+    }
+    if ((events & (EPOLLIN | EPOLLRDHUP)) && read_stream(link) < 0) {
+        tcp_disconnect(link);
+    }
+}
+
+static void on_reconnect_timer(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    event_timer_read(fd);
+    if (link->addrlen == 0) {
+        return;     // the resolver starts the connect
+    }
+    if (link->fd < 0 && tcp_start_connect(link) < 0) {
+        event_timer_set(link->reconnect_fd, RELAY_RECONNECT_MS, 0);
+    }
+}
+
+/**
+ * forward a frame received on an udp link, on a server link the system
+ * behind the session is counted
+ * @param link
+ * @param frame
+ * @param key session, NULL on a client link
+ * @param client last counted system, updated
+ * @param now
+ */
+static void udp_forward(link_t *link, const mav_frame_t *frame, client_key_t *key, client_t **client, uint64_t now) {
+    if (key) {
+        if (!*client || (*client)->key.sysid != frame->sysid) {
+            key->sysid = frame->sysid;
+            *client = clients_touch(link->clients, key, now, NULL);
+        }
+        if (*client) (*client)->rx_frames++;
+        key->sysid = 0;
+    }
+    relay_forward(link, frame, key);
+}
+
+/**
+ * tunnel state of the peer a codec or FEC datagram came from. A server
+ * session gets one with the first such datagram.
+ * @return NULL if there is none
+ */
+static tunnel_t* peer_tunnel(link_t *link, client_t *session) {
+    if (!session) {
+        return link->tunnel;
+    }
+    if (!session->state) {
+        tunnel_t *t = new_tunnel(link);
+        if (!t) {
+            return NULL;
+        }
+        t->addrlen = client_key_to_sockaddr(&session->key, &t->addr);
+        session->state = t;
+    }
+    return session->state;
+}
+
+/**
+ * decode a codec datagram or answer a handshake
+ */
+static void receive_tunnel(link_t *link, tunnel_t *t, const uint8_t *data, int len,
+        client_key_t *key, uint64_t now) {
+    mav_frame_t frame;
+    client_t *client = NULL;
+
+    if (data[1] == TUNNEL_CONTROL) {
+        uint8_t reply[TUNNEL_CONTROL_LEN];
+        int n = tunnel_control(t, data, len, reply);
+        if (n > 0) {
+            sendto(link->fd, reply, n, 0, t->addrlen ? (struct sockaddr*) &t->addr : NULL, t->addrlen);
+        }
+        if (t->version != 0) {
+            LOG__DEBUG("%s: tunnel codec version %d", link->name, t->version);
+        }
+        return;
+    }
+    if (!tunnel_attach(t, data, len)) {
+        t->stats->bad++;
+        return;
+    }
+    while (tunnel_next(t, &frame)) {
+        udp_forward(link, &frame, key, &client, now);
+    }
+}
+
+/**
+ * forward the frames of a datagram (codec or raw)
+ */
+static void receive_datagram(link_t *link, client_t *session, client_key_t *peer,
+        const uint8_t *data, int len, uint64_t now) {
+    mav_frame_t frame;
+    client_t *client = NULL;
+
+    if (link->compress && tunnel_is_codec(data, len)) {
+        tunnel_t *t = peer_tunnel(link, session);
+        if (t) {
+            receive_tunnel(link, t, data, len, peer, now);
+            return;
+        }
+    }
+    // the datagram stays in udp_rx until the next receive, parse it in place
+    framer_attach(&link->framer, data, len);
+    while (framer_next(&link->framer, &frame)) {
+        udp_forward(link, &frame, peer, &client, now);
+    }
+}
+
+/**
+ * udp socket is readable: receive until EAGAIN and forward complete frames.
+ * On a server link every source address is a client session.
+ */
+static void on_udp_event(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    uint64_t now = event_now_ms();
+
+    for (;;) {
+        int n = udp_recv_batch(fd, &udp_rx);
+        LOG__TRACE("read %d datagrams from udp port...", n);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EINTR && errno != ECONNREFUSED) {
+                LOG__ERROR("recv udp %s: %s", link->name, strerror(errno));
+            }
+            if (errno != ECONNREFUSED) break;
+            continue;
+        }
+
+        for (int i = 0; i < n; i++) {
+            client_t *session = NULL;
+            client_key_t key;
+            const uint8_t *data = udp_rx.buffer[i];
+            int len = udp_rx.msgs[i].msg_len;
+
+            if (link->type == LINK_UDP_SERVER) {
+                int created;
+                client_key_from_sockaddr(&key, &udp_rx.addr[i], 0);
+                session = clients_touch(link->clients, &key, now, &created);
+                if (!session) {
+                    continue;   // table full
+                }
+                if (created) {
+                    char name[80];
+                    LOG__INFO("%s: new client %s", link->name, client_key_to_string(&key, name, sizeof (name)));
+                }
+            }
+            client_key_t *peer = session ? &key : NULL;
+            tunnel_t *t;
+
+            if (fec_is_fec(data, len) && (t = peer_tunnel(link, session)) != NULL) {
+                const uint8_t *payload;
+                const uint8_t *recovered;
+                int recovered_len;
+                int plen = fec_receive(&t->fec, data, len, now, &payload, &recovered, &recovered_len);
+                if (plen > 0) {
+                    receive_datagram(link, session, peer, payload, plen, now);
+                }
+                if (recovered_len > 0) {
+                    EVENTLOG(EVENTLOG_FEC_RECOVERED, link->id, recovered_len);
+                    receive_datagram(link, session, peer, recovered, recovered_len, now);
+                }
+                continue;
+            }
+            receive_datagram(link, session, peer, data, len, now);
+        }
+
+        if (n < UDP_BATCH_SIZE) {
+            break;  // socket drained, the next datagram triggers a new edge
+        }
+    }
+    relay_flush();
+}
+
+/**
+ * send the held frames of capped messages whose time has come
+ */
+static void on_rate_timer(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    uint64_t now = event_now_ms();
+    client_key_t peer;
+    bool has_peer;
+    framebuf_t *fb;
+
+    event_timer_read(fd);
+    link->rate_due = 0;
+    while ((fb = ratecap_take_due(link->rates, now, &peer, &has_peer)) != NULL) {
+        link_output(link, fb, has_peer ? &peer : NULL);
+        framebuf_unref(fb);
+    }
+    arm_rate_timer(link);
+    relay_flush();
+}
+
+/**
+ * the window of the open FEC groups has passed: send their data and close
+ * them with the parity
+ */
+static void on_fec_timer(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    event_timer_read(fd);
+    link->fec_armed = false;
+    if (link_pending(link)) {
+        link_flush(link);
+    }
+    if (link->tunnel && fec_group_open(&link->tunnel->fec)) {
+        queue_parity(link, link->tunnel);
+    }
+    if (link->clients) {
+        for (int i = 0; i < link->clients->count; i++) {
+            tunnel_t *t = link->clients->entries[i].state;
+            if (t && fec_group_open(&t->fec)) {
+                queue_parity(link, t);
+            }
+        }
+    }
+    send_parity(link);
+}
+
+static void on_read_timer(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    event_timer_read(fd);
+    if (link->fd >= 0 && read_stream(link) < 0) {
+        serial_disconnect(link);
+    }
+}
+
+static void on_pace_timer(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    event_timer_read(fd);
+    link->pace_armed = false;
+    serial_drain(link);
+}
+
+static void on_expire_timer(int fd, uint32_t events, void *ctx) {
+    link_t *link = ctx;
+    event_timer_read(fd);
+    if (link_pending(link)) {
+        link_flush(link);       // the tunnel state of expired sessions is freed
+    }
+    clients_expire(link->clients, event_now_ms(), CLIENTS_IDLE_TIMEOUT_MS);
+}
+
+static void on_router_timer(int fd, uint32_t events, void *ctx) {
+    event_timer_read(fd);
+    router_expire(&router, event_now_ms(), ROUTER_IDLE_TIMEOUT_MS);
+}
+
+/**
+ * log the statistics of all links
+ */
+void relay_status(void) {
+    const framebuf_stats_t *fbstats = framebuf_stats();
+    const convert_stats_t *cvstats = convert_stats();
+    LOG__INFO("router: %d routes, %u rejected", router.count, router.rejected);
+    LOG__INFO("frame buffers: %u in use, max %u of %u, %u exhausted",
+            fbstats->in_use, fbstats->in_use_max, fbstats->size, fbstats->exhausted);
+    if (dedup) {
+        LOG__INFO("dedup: %d sources, %u duplicates, %u frames not checked (table full)",
+                dedup->count, dedup->duplicates, dedup->full);
+    }
+    if (cvstats->converted > 0 || cvstats->dropped > 0) {
+        LOG__INFO("mavlink version: %u frames converted, %u bytes saved by truncation, %u without v1 representation",
+                cvstats->converted, cvstats->saved_bytes, cvstats->dropped);
+    }
+
+    for (int i = 0; i < link_count; i++) {
+        link_t *link = &links[i];
+        LOG__INFO("link %d %s: rx %u frames, tx %u frames, %u dropped, %u filtered, %u bad crc, %u bytes skipped",
+                link->id, link->name, link->rx_frames, link->tx_frames, link->tx_dropped, link->filtered,
+                link->framer.stats.bad_crc, link->framer.stats.skipped_bytes);
+        if (dedup) {
+            LOG__INFO("link %d %s: %u first copies, %u duplicates, %u frames lost (seq gaps)",
+                    link->id, link->name, link->dedup.first, link->dedup.duplicates, link->dedup.lost);
+        }
+        if (link->type == LINK_SERIAL) {
+            statusSerial(&link->serial);
+            txsched_status(&link->sched, link->name);
+            LOG__INFO("link %d %s: radio txbuf %d%%, rate %d%%, %u status, %u throttled, %u downsampled",
+                    link->id, link->name, link->flow.txbuf, link->flow.percent, link->flow.status_count,
+                    link->flow.throttled, link->flow.downsampled);
+        } else if (link->type != LINK_TCP_CLIENT) {
+            LOG__INFO("link %d %s: %u datagrams sent with %u frames, %u dropped on send", link->id, link->name,
+                    link->tx.datagrams, link->tx.frames, link->tx.dropped);
+        }
+        if (link->clients) {
+            LOG__INFO("link %d %s: %d clients, %u rejected", link->id, link->name,
+                    link->clients->count, link->clients->rejected);
+            for (int c = 0; dedup && c < link->clients->count; c++) {
+                const client_t *session = &link->clients->entries[c];
+                char name[80];
+                if (session->key.sysid != 0) continue;
+                LOG__INFO("link %d %s: client %s: %u first copies, %u duplicates, %u frames lost (seq gaps)",
+                        link->id, link->name, client_key_to_string(&session->key, name, sizeof (name)),
+                        session->first, session->duplicates, session->lost);
+            }
+        }
+        if (link->compress) {
+            const tunnel_stats_t *ts = &link->tunnel_stats;
+            LOG__INFO("link %d %s: tunnel codec %u frames, %llu -> %llu bytes (%u keys, %u deltas), "
+                    "rx %u frames, %u without key, %u bad",
+                    link->id, link->name, ts->tx_frames, (unsigned long long) ts->raw_bytes,
+                    (unsigned long long) ts->coded_bytes, ts->keys, ts->deltas, ts->rx_frames, ts->no_ref, ts->bad);
+        }
+        if (link->fec_k > 0 || link->fec_stats.rx_parity > 0) {
+            const fec_stats_t *fs = &link->fec_stats;
+            LOG__INFO("link %d %s: FEC %u parity datagrams (%u bytes), rx %u parity, %u recovered, "
+                    "%u unrecoverable, %u too late, %u duplicates",
+                    link->id, link->name, fs->groups, fs->parity_bytes, fs->rx_parity, fs->recovered,
+                    fs->unrecoverable, fs->late, fs->duplicates);
+        }
+        if (link->rates) {
+            LOG__INFO("link %d %s: %d rate caps, %d sources, %u frames held, %u replaced by newer, %u dropped (too many sources)",
+                    link->id, link->name, link->rates->count, link->rates->sources_used,
+                    link->rates->held, link->rates->replaced, link->rates->full);
+        }
+    }
+}
+
+/**
+ * close all links
+ */
+void relay_close(void) {
+    for (int i = 0; i < link_count; i++) {
+        link_t *link = &links[i];
+        if ((link->type == LINK_UDP_CLIENT || link->type == LINK_UDP_SERVER) && link_pending(link)) {
+            link_flush(link);
+        }
+    }
+    for (int i = 0; i < link_count; i++) {
+        link_t *link = &links[i];
+        if (link->fd >= 0) {
+            event_remove(link->fd);
+        }
+        switch (link->type) {
+            case LINK_SERIAL:
+                txsched_clear(&link->sched);
+                event_remove(link->pace_fd);
+                event_remove(link->reconnect_fd);
+                if (link->read_fd >= 0) event_remove(link->read_fd);
+                closeSerial(&link->serial);
+                break;
+            case LINK_UDP_CLIENT:
+            case LINK_UDP_SERVER:
+                if (link->fd >= 0) close(link->fd);
+                if (link->coalesce_fd >= 0) event_remove(link->coalesce_fd);
+                if (link->fec_fd >= 0) event_remove(link->fec_fd);
+                free(link->parity);
+                link->parity = NULL;
+                udp_batch_free(&link->tx);
+                break;
+            case LINK_TCP_CLIENT:
+                if (link->fd >= 0) close(link->fd);
+                event_remove(link->reconnect_fd);
+                ringbuf_free(&link->stream_tx);
+                break;
+        }
+        if (link->clients) {
+            for (int c = 0; c < link->clients->count; c++) {
+                free(link->clients->entries[c].state);
+            }
+        }
+        free(link->clients);
+        link->clients = NULL;
+        free(link->tunnel);
+        link->tunnel = NULL;
+        free(link->filter);
+        link->filter = NULL;
+        if (link->rates) {
+            event_remove(link->rate_fd);
+            ratecap_free(link->rates);
+            link->rates = NULL;
+        }
+    }
+    link_count = 0;
+    relay_set_dedup(false);
+    udp_batch_free(&udp_rx);
+    framebuf_close();
+}
@@ -0,0 +1,292 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   replay.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "replay.h"
+#include "relay.h"
+#include "event.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/*
+ * replay: the frames of a tlog go through the whole relay as if they came
+ * from a serial port. They are written into a pty, whose other side is a
+ * serial link of the relay, or sent to a udp server link on localhost.
+ * The time stamps of the tlog give the timing, divided by speed. Speed 0
+ * sends as fast as the input takes them. The program ends after the tlog.
+ */
+
+extern volatile sig_atomic_t stop_requested;
+extern char *progname;
+
+static const uint8_t *data = NULL;  // the tlog, mapped
+static size_t size = 0;
+static size_t pos = 0;              // next record
+static size_t written = 0;          // bytes of the current frame already in the input
+static double speed = 1.0;
+static int out_fd = -1;             // pty master or udp socket
+static bool udp = false;
+static int timer_fd = -1;
+static uint64_t start_ms = 0;
+static uint64_t first_us = 0;       // time stamp of the first frame
+static bool first = true;
+static replay_stats_t stats;
+
+/**
+ * length of the frame at p, 0 if there is no frame header
+ */
+static size_t frame_length(const uint8_t *p, size_t avail) {
+    if (avail < 3) {
+        return 0;
+    }
+    size_t len;
+    if (p[0] == MAVLINK_STX_MAVLINK1) {
+        len = MAVLINK_V1_HEADER_LEN + p[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+    } else if (p[0] == MAVLINK_STX) {
+        len = MAVLINK_V2_HEADER_LEN + p[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+        if (p[2] & MAVLINK_IFLAG_SIGNED) {
+            len += MAVLINK_SIGNATURE_BLOCK_LEN;
+        }
+    } else {
+        return 0;
+    }
+    return len <= avail ? len : 0;
+}
+
+/**
+ * the next record of the tlog
+ * @param time_us time stamp
+ * @param frame
+ * @return frame length, 0 at the end of the tlog
+ */
+static size_t next_record(uint64_t *time_us, const uint8_t **frame) {
+    while (pos + 8 < size) {
+        size_t len = frame_length(data + pos + 8, size - pos - 8);
+        if (len == 0) {
+            // no record here, search the next one
+            stats.skipped++;
+            pos++;
+            continue;
+        }
+        uint64_t t = 0;
+        for (int i = 0; i < 8; i++) {
+            t = (t << 8) | data[pos + i];
+        }
+        *time_us = t;
+        *frame = data + pos + 8;
+        return len;
+    }
+    return 0;
+}
+
+static void on_drain_timer(int fd, uint32_t events, void *ctx) {
+    event_timer_read(fd);
+    stop_requested = 1;
+}
+
+static void finish(void) {
+    double s = (event_now_ms() - start_ms) / 1000.0;
+    LOG__INFO("replay: %u frames, %llu bytes in %.3f s (%.0f frames/s), %u bytes skipped, input full %u times",
+            stats.frames, (unsigned long long) stats.bytes, s, s > 0 ? stats.frames / s : 0.0,
+            stats.skipped, stats.waits);
+    event_timer_set(timer_fd, 0, 0);
+    if (event_add_timer(REPLAY_DRAIN_MS, on_drain_timer, NULL) < 0) {
+        stop_requested = 1;
+    }
+}
+
+/**
+ * write the frames which are due, arm the timer for the next one
+ */
+static void on_replay_timer(int fd, uint32_t events, void *ctx) {
+    event_timer_read(fd);
+
+    uint64_t now = event_now_ms();
+    for (int n = 0; speed > 0 || n < REPLAY_BATCH; n++) {
+        uint64_t time_us;
+        const uint8_t *frame;
+        size_t len = next_record(&time_us, &frame);
+        if (len == 0) {
+            finish();
+            return;
+        }
+
+        if (first) {
+            first_us = time_us;
+            first = false;
+        }
+        if (speed > 0) {
+            // time stamps going back (clock set) count as due
+            uint64_t offset_ms = time_us > first_us ? (time_us - first_us) / 1000 : 0;
+            uint64_t due = start_ms + (uint64_t) (offset_ms / speed);
+            if (due > now) {
+                event_timer_set(timer_fd, due - now, 0);
+                return;
+            }
+        }
+
+        ssize_t ret = udp ? send(out_fd, frame, len, 0) : write(out_fd, frame + written, len - written);
+        if (ret < 0) {
+            if (errno != EAGAIN && errno != EINTR && errno != ECONNREFUSED) {
+                LOG__ERROR("replay: write input: %s", strerror(errno));
+                finish();
+                return;
+            }
+            stats.waits++;
+            event_timer_set(timer_fd, REPLAY_RETRY_MS, 0);
+            return;
+        }
+        if (!udp && written + ret < len) {
+            // pty buffer full within the frame
+            written += ret;
+            stats.waits++;
+            event_timer_set(timer_fd, REPLAY_RETRY_MS, 0);
+            return;
+        }
+        written = 0;
+        pos += 8 + len;
+        stats.frames++;
+        stats.bytes += len;
+    }
+    event_timer_set(timer_fd, REPLAY_RETRY_MS, 0);
+}
+
+/**
+ * pty pair, the slave becomes a serial link of the relay
+ */
+static int open_pty(int baudrate, const serial_opt_t *opt) {
+    out_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (out_fd < 0 || grantpt(out_fd) < 0 || unlockpt(out_fd) < 0) {
+        LOG__ERROR("replay: pty: %s", strerror(errno));
+        return -1;
+    }
+    const char *slave = ptsname(out_fd);
+    if (!slave || !relay_add_serial(slave, baudrate, opt)) {
+        LOG__ERROR("replay: serial link on the pty failed");
+        return -1;
+    }
+    LOG__INFO("replay: input pty %s", slave);
+    return 0;
+}
+
+/**
+ * udp server link of the relay, the replay is its client on localhost
+ */
+static int open_udp(int port) {
+    if (!relay_add_udp_server(port)) {
+        return -1;
+    }
+    out_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof (sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (out_fd < 0 || connect(out_fd, (struct sockaddr*) &sa, sizeof (sa)) < 0) {
+        LOG__ERROR("replay: udp socket: %s", strerror(errno));
+        return -1;
+    }
+    LOG__INFO("replay: input udp port %d", port);
+    return 0;
+}
+
+/**
+ * replay a tlog into the relay
+ * @param file tlog
+ * @param factor speed, 1 = original timing, 0 = as fast as possible
+ * @param udp_port 0 = pty input, otherwise the udp port of the input link
+ * @param baudrate of the serial link on the pty
+ * @param opt of the serial link on the pty
+ * @return 0 if ok
+ */
+int replay_start(const char *file, double factor, int udp_port, int baudrate, const serial_opt_t *opt) {
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        fprintf(stderr, "%s: replay %s: %s\n", progname, file, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    size = st.st_size;
+    data = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (data == MAP_FAILED || data == NULL) {
+        fprintf(stderr, "%s: replay %s: empty or not readable\n", progname, file);
+        data = NULL;
+        return -1;
+    }
+    madvise((void*) data, size, MADV_SEQUENTIAL);
+
+    speed = factor;
+    udp = udp_port > 0;
+    if ((udp ? open_udp(udp_port) : open_pty(baudrate, opt)) < 0) {
+        replay_close();
+        return -1;
+    }
+
+    // first frame after the event loop runs
+    timer_fd = event_add_timer(0, on_replay_timer, NULL);
+    if (timer_fd < 0) {
+        replay_close();
+        return -1;
+    }
+    event_timer_set(timer_fd, REPLAY_RETRY_MS, 0);
+    start_ms = event_now_ms() + REPLAY_RETRY_MS;
+    if (speed > 0) {
+        LOG__INFO("replay: %s, %zu bytes, speed %.2fx", file, size, speed);
+    } else {
+        LOG__INFO("replay: %s, %zu bytes, full speed", file, size);
+    }
+    return 0;
+}
+
+void replay_close(void) {
+    if (timer_fd >= 0) {
+        event_remove(timer_fd);
+        timer_fd = -1;
+    }
+    if (out_fd >= 0) {
+        close(out_fd);
+        out_fd = -1;
+    }
+    if (data) {
+        munmap((void*) data, size);
+        data = NULL;
+    }
+}
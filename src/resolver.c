@@ -0,0 +1,294 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   resolver.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "resolver.h"
+#include "event.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+
+/*
+ * getaddrinfo() blocks until the DNS server answers. It runs in a resolver
+ * thread, the event loop is woken by an eventfd when a result is ready.
+ */
+
+typedef struct __resolve_entry_t {
+    char host[64];
+    char service[8];
+    int socktype;
+    resolve_cb_t cb;
+    void *ctx;
+    bool request;               // lookup wanted (thread)
+    bool done;                  // result ready (event loop)
+    int error;                  // getaddrinfo result
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    struct sockaddr_storage current;    // last address given to cb
+    socklen_t current_len;
+    uint64_t next_ms;           // next lookup
+} resolve_entry_t;
+
+static resolve_entry_t entries[RESOLVER_MAX_ENTRIES];
+static int entry_count = 0;
+static pthread_t thread;
+static bool thread_running = false;
+static bool thread_stop = false;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int notify_fd = -1;
+static int timer_fd = -1;
+
+static int lookup(const char *host, const char *service, int socktype, int flags,
+        struct sockaddr_storage *addr, socklen_t *addrlen) {
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = socktype;
+    hints.ai_flags = flags | AI_ADDRCONFIG;
+
+    int err = getaddrinfo(host, service, &hints, &res);
+    if (err != 0) {
+        return err;
+    }
+    memcpy(addr, res->ai_addr, res->ai_addrlen);
+    *addrlen = res->ai_addrlen;
+    freeaddrinfo(res);
+    return 0;
+}
+
+static void* resolver_thread(void *arg) {
+    pthread_mutex_lock(&lock);
+    while (!thread_stop) {
+        int i;
+        for (i = 0; i < entry_count; i++) {
+            if (entries[i].request) break;
+        }
+        if (i == entry_count) {
+            pthread_cond_wait(&cond, &lock);
+            continue;
+        }
+
+        resolve_entry_t *e = &entries[i];
+        e->request = false;
+        char host[64], service[8];
+        int socktype = e->socktype;
+        strcpy(host, e->host);
+        strcpy(service, e->service);
+        pthread_mutex_unlock(&lock);
+
+        struct sockaddr_storage addr;
+        socklen_t addrlen = 0;
+        int err = lookup(host, service, socktype, 0, &addr, &addrlen);
+
+        pthread_mutex_lock(&lock);
+        e->error = err;
+        if (err == 0) {
+            e->addr = addr;
+            e->addrlen = addrlen;
+        }
+        e->done = true;
+        uint64_t one = 1;
+        if (write(notify_fd, &one, sizeof (one)) < 0) {
+            // counter overflow is impossible here, the loop reads it
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+/**
+ * results of the thread: hand new addresses to the owners
+ */
+static void on_notify(int fd, uint32_t events, void *ctx) {
+    uint64_t count;
+    if (read(fd, &count, sizeof (count)) < 0) {
+        // nothing pending
+    }
+
+    uint64_t now = event_now_ms();
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < entry_count; i++) {
+        resolve_entry_t *e = &entries[i];
+        if (!e->done) continue;
+        e->done = false;
+
+        if (e->error != 0) {
+            LOG__WARN("resolve %s: %s", e->host, gai_strerror(e->error));
+            e->next_ms = now + RESOLVER_RETRY_MS;
+            continue;
+        }
+        e->next_ms = now + RESOLVER_INTERVAL_MS;
+        if (e->addrlen == e->current_len && memcmp(&e->addr, &e->current, e->addrlen) == 0) {
+            continue;
+        }
+        e->current = e->addr;
+        e->current_len = e->addrlen;
+
+        char ip[64] = "?";
+        getnameinfo((struct sockaddr*) &e->current, e->current_len, ip, sizeof (ip), NULL, 0, NI_NUMERICHOST);
+        LOG__INFO("resolve %s: %s", e->host, ip);
+
+        // the callback may call resolver_add(), don't hold the lock
+        pthread_mutex_unlock(&lock);
+        e->cb(e->ctx, (struct sockaddr*) &e->current, e->current_len);
+        pthread_mutex_lock(&lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * periodic re-resolution of the names
+ */
+static void on_timer(int fd, uint32_t events, void *ctx) {
+    event_timer_read(fd);
+
+    uint64_t now = event_now_ms();
+    bool wakeup = false;
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < entry_count; i++) {
+        if (entries[i].next_ms != 0 && now >= entries[i].next_ms) {
+            entries[i].next_ms = 0;
+            entries[i].request = true;
+            wakeup = true;
+        }
+    }
+    if (wakeup) {
+        pthread_cond_signal(&cond);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * start the resolver thread
+ * @return 0 if ok
+ */
+int resolver_init(void) {
+    entry_count = 0;
+    thread_stop = false;
+
+    notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notify_fd < 0) {
+        LOG__ERROR("eventfd: %s", strerror(errno));
+        return -1;
+    }
+    if (event_add(notify_fd, EPOLLIN, on_notify, NULL) < 0) {
+        return -1;
+    }
+    timer_fd = event_add_timer(RESOLVER_RETRY_MS, on_timer, NULL);
+    if (timer_fd < 0) {
+        return -1;
+    }
+
+    // signals are handled by the event loop (signalfd), not by the thread
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&thread, NULL, resolver_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        LOG__ERROR("create resolver thread failed: %s", strerror(err));
+        return -1;
+    }
+    thread_running = true;
+    return 0;
+}
+
+/**
+ * resolve host:port. Numeric addresses are converted at once, host names are
+ * looked up by the resolver thread and again every RESOLVER_INTERVAL_MS.
+ * cb is called from the event loop whenever the address changes.
+ *
+ * @param host name, IPv4 or IPv6 address
+ * @param port
+ * @param socktype SOCK_DGRAM or SOCK_STREAM
+ * @param cb
+ * @param ctx
+ * @return 0 if ok
+ */
+int resolver_add(const char *host, int port, int socktype, resolve_cb_t cb, void *ctx) {
+    char service[8];
+    snprintf(service, sizeof (service), "%d", port);
+
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    if (lookup(host, service, socktype, AI_NUMERICHOST, &addr, &addrlen) == 0) {
+        cb(ctx, (struct sockaddr*) &addr, addrlen);
+        return 0;
+    }
+
+    pthread_mutex_lock(&lock);
+    if (entry_count >= RESOLVER_MAX_ENTRIES) {
+        pthread_mutex_unlock(&lock);
+        LOG__ERROR("resolve %s: too many host names", host);
+        return -1;
+    }
+    resolve_entry_t *e = &entries[entry_count++];
+    memset(e, 0, sizeof (*e));
+    strncpy(e->host, host, sizeof (e->host) - 1);
+    strcpy(e->service, service);
+    e->socktype = socktype;
+    e->cb = cb;
+    e->ctx = ctx;
+    e->request = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+
+    LOG__DEBUG("resolve %s in background", host);
+    return 0;
+}
+
+/**
+ * stop the resolver thread. A lookup in progress is waited for.
+ */
+void resolver_close(void) {
+    if (thread_running) {
+        pthread_mutex_lock(&lock);
+        thread_stop = true;
+        pthread_cond_signal(&cond);
+        pthread_mutex_unlock(&lock);
+        pthread_join(thread, NULL);
+        thread_running = false;
+    }
+    if (timer_fd >= 0) {
+        event_remove(timer_fd);
+        timer_fd = -1;
+    }
+    if (notify_fd >= 0) {
+        event_remove(notify_fd);
+        close(notify_fd);
+        notify_fd = -1;
+    }
+}
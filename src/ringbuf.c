@@ -0,0 +1,102 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   ringbuf.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "ringbuf.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * allocate the ring buffer
+ * @param rb
+ * @param size rounded up to a power of two
+ * @return 0 if ok
+ */
+int ringbuf_init(ringbuf_t *rb, size_t size) {
+    size_t s = 1;
+    while (s < size) s <<= 1;
+
+    rb->data = malloc(s);
+    if (!rb->data) return -1;
+    rb->size = s;
+    rb->head = 0;
+    rb->tail = 0;
+    return 0;
+}
+
+void ringbuf_free(ringbuf_t *rb) {
+    free(rb->data);
+    rb->data = NULL;
+    rb->size = 0;
+    rb->head = rb->tail = 0;
+}
+
+/**
+ * append data, as much as fits
+ * @param rb
+ * @param data
+ * @param len
+ * @return number of bytes written
+ */
+size_t ringbuf_write(ringbuf_t *rb, const uint8_t *data, size_t len) {
+    size_t space = ringbuf_space(rb);
+    if (len > space) len = space;
+
+    size_t idx = rb->head & (rb->size - 1);
+    size_t first = rb->size - idx;
+    if (first > len) first = len;
+    memcpy(rb->data + idx, data, first);
+    memcpy(rb->data, data + first, len - first);
+    rb->head += len;
+    return len;
+}
+
+/**
+ * returns the contiguous readable block at the read position
+ * @param rb
+ * @param data
+ * @return length of the block
+ */
+size_t ringbuf_peek(const ringbuf_t *rb, const uint8_t **data) {
+    size_t used = ringbuf_used(rb);
+    size_t idx = rb->tail & (rb->size - 1);
+    size_t first = rb->size - idx;
+
+    *data = rb->data + idx;
+    return used < first ? used : first;
+}
+
+/**
+ * remove len bytes at the read position
+ * @param rb
+ * @param len
+ */
+void ringbuf_consume(ringbuf_t *rb, size_t len) {
+    size_t used = ringbuf_used(rb);
+    rb->tail += (len < used) ? len : used;
+}
@@ -0,0 +1,204 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   router.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "router.h"
+#include "logging.h"
+#include <string.h>
+
+/**
+ * initialize an empty routing table
+ * @param router
+ */
+void router_init(router_t *router) {
+    router->count = 0;
+    router->rejected = 0;
+    for (int i = 0; i < 256; i++) {
+        router->systems[i] = -1;
+    }
+    memset(router->index, 0, sizeof (router->index));
+}
+
+static inline uint32_t route_hash(uint8_t sysid, uint8_t compid) {
+    uint32_t key = ((uint32_t) sysid << 8) | compid;
+    return (key * 2654435761u) >> 16;
+}
+
+static uint32_t find_slot(const router_t *router, uint8_t sysid, uint8_t compid) {
+    uint32_t mask = ROUTER_INDEX_SIZE - 1;
+    uint32_t slot = route_hash(sysid, compid) & mask;
+    while (router->index[slot] != 0) {
+        const route_t *route = &router->routes[router->index[slot] - 1];
+        if (route->sysid == sysid && route->compid == compid) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * remember the link (and session) a frame came from
+ * @param router
+ * @param frame
+ * @param link
+ * @param peer session key on server links, NULL otherwise
+ * @param now_ms
+ */
+void router_learn(router_t *router, const mav_frame_t *frame, uint16_t link, const client_key_t *peer, uint64_t now_ms) {
+    uint32_t slot = find_slot(router, frame->sysid, frame->compid);
+    route_t *route;
+
+    if (router->index[slot] != 0) {
+        route = &router->routes[router->index[slot] - 1];
+        if (route->link == link && (!peer || memcmp(&route->peer, peer, sizeof (*peer)) == 0)) {
+            route->last_seen = now_ms;
+            return;
+        }
+        if (now_ms - route->last_seen < ROUTER_HOLD_MS) {
+            // still fresh on its link, a copy over a redundant path doesn't move it
+            return;
+        }
+        LOG__DEBUG("route %u/%u moved from link %u to link %u", frame->sysid, frame->compid, route->link, link);
+    } else {
+        if (router->count >= ROUTER_MAX_ROUTES) {
+            router->rejected++;
+            return;
+        }
+        route = &router->routes[router->count];
+        route->sysid = frame->sysid;
+        route->compid = frame->compid;
+        route->next = router->systems[frame->sysid];
+        router->systems[frame->sysid] = (int16_t) router->count;
+        router->index[slot] = (uint16_t) (++router->count);
+        LOG__INFO("route %u/%u learned on link %u", frame->sysid, frame->compid, link);
+    }
+
+    route->link = link;
+    if (peer) {
+        route->peer = *peer;
+    } else {
+        memset(&route->peer, 0, sizeof (route->peer));
+    }
+    route->last_seen = now_ms;
+}
+
+/**
+ * read target_system/target_component of a frame without decoding it.
+ * Truncated MAVLink v2 payloads have zeros at the end.
+ *
+ * @param frame
+ * @param target_system
+ * @param target_component
+ * @return false if the message has no target
+ */
+bool router_get_target(const mav_frame_t *frame, uint8_t *target_system, uint8_t *target_component) {
+    const mavlink_msg_entry_t *entry = frame->entry;
+    if (!entry || !(entry->flags & MAV_MSG_ENTRY_FLAG_HAVE_TARGET_SYSTEM)) {
+        return false;
+    }
+
+    *target_system = (entry->target_system_ofs < frame->payload_len) ? frame->payload[entry->target_system_ofs] : 0;
+    *target_component = 0;
+    if ((entry->flags & MAV_MSG_ENTRY_FLAG_HAVE_TARGET_COMPONENT) && entry->target_component_ofs < frame->payload_len) {
+        *target_component = frame->payload[entry->target_component_ofs];
+    }
+    return true;
+}
+
+/**
+ * find the routes of a target. Component 0 means all components of the
+ * system.
+ *
+ * @param router
+ * @param sysid
+ * @param compid
+ * @param routes
+ * @param max
+ * @return number of routes, 0 if the target is unknown
+ */
+int router_find(const router_t *router, uint8_t sysid, uint8_t compid, const route_t **routes, int max) {
+    int n = 0;
+
+    if (compid != 0) {
+        uint32_t slot = find_slot(router, sysid, compid);
+        if (router->index[slot] != 0) {
+            routes[n++] = &router->routes[router->index[slot] - 1];
+            return n;
+        }
+        // unknown component, try the system
+    }
+
+    for (int i = router->systems[sysid]; i >= 0 && n < max; i = router->routes[i].next) {
+        routes[n++] = &router->routes[i];
+    }
+    return n;
+}
+
+/**
+ * remove routes not seen for idle_ms. The table is built again from the
+ * remaining routes, so the index and the chains of a system stay dense.
+ *
+ * @param router
+ * @param now_ms
+ * @param idle_ms
+ * @return number of removed routes
+ */
+int router_expire(router_t *router, uint64_t now_ms, uint64_t idle_ms) {
+    int count = 0;
+
+    for (int i = 0; i < router->count; i++) {
+        const route_t *route = &router->routes[i];
+        if (now_ms - route->last_seen >= idle_ms) {
+            LOG__DEBUG("route %u/%u on link %u expired", route->sysid, route->compid, route->link);
+            continue;
+        }
+        if (count != i) {
+            router->routes[count] = *route;
+        }
+        count++;
+    }
+    int removed = router->count - count;
+    if (removed == 0) {
+        return 0;
+    }
+
+    router->count = 0;
+    for (int i = 0; i < 256; i++) {
+        router->systems[i] = -1;
+    }
+    memset(router->index, 0, sizeof (router->index));
+    for (int i = 0; i < count; i++) {
+        route_t *route = &router->routes[i];
+        route->next = router->systems[route->sysid];
+        router->systems[route->sysid] = (int16_t) i;
+        router->index[find_slot(router, route->sysid, route->compid)] = (uint16_t) (i + 1);
+    }
+    router->count = count;
+    return removed;
+}
@@ -28,6 +28,7 @@
  */
 
 #include "serial.h"
+#include "baudrate.h"
 #include "logging.h"
 #include <fcntl.h>
 #include <termios.h>
@@ -35,13 +36,45 @@
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
-#include <pthread.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <linux/serial.h>
 
 
 extern char *progname;
-pthread_mutex_t lock_tty;
 
-int openSerial(const char* device, int baudrate) {
+/**
+ * ask the driver to pass received bytes on at once. USB serial adapters
+ * (ftdi_sio) otherwise collect them for their latency timer of up to 16 ms.
+ * @return true if the driver accepted it
+ */
+static bool set_low_latency(int fd, const char* device) {
+    struct serial_struct ss;
+    if (ioctl(fd, TIOCGSERIAL, &ss) < 0) {
+        LOG__WARN("serial port %s: low latency not supported: %s", device, strerror(errno));
+        return false;
+    }
+    ss.flags |= ASYNC_LOW_LATENCY;
+    if (ioctl(fd, TIOCSSERIAL, &ss) < 0) {
+        LOG__WARN("serial port %s: set low latency failed: %s", device, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * open and configure a serial port (8N1, raw)
+ * @param port
+ * @param device
+ * @param baudrate
+ * @param opt tuning, NULL = defaults
+ * @return fd or -1
+ */
+int openSerial(serial_port_t* port, const char* device, int baudrate, const serial_opt_t* opt) {
+    static const serial_opt_t defaults = {false, false, 1, 0, false};
+    if (!opt) opt = &defaults;
 
     LOG__DEBUG("serial port %s try to open", device);
 
@@ -50,7 +83,8 @@ int openSerial(const char* device, int baudrate) {
         fprintf(stderr, "%s: error to open device %s: %s\n", progname, device, strerror(errno));
         return -1;
     } else {
-        fcntl(fd, F_SETFL, 0);
+        // stay non-blocking, the fd is driven by the event loop
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
     }
 
     LOG__DEBUG("serial port %s opend", device);
@@ -63,35 +97,6 @@ int openSerial(const char* device, int baudrate) {
         return -1;
     }
 
-    switch (baudrate) {
-        case 9600:
-            cfsetispeed(&options, B9600);
-            cfsetospeed(&options, B9600);
-            break;
-        case 19200:
-            cfsetispeed(&options, B19200);
-            cfsetospeed(&options, B19200);
-            break;
-        case 38400:
-            cfsetispeed(&options, B38400);
-            cfsetospeed(&options, B38400);
-            break;
-        case 57600:
-            cfsetispeed(&options, B57600);
-            cfsetospeed(&options, B57600);
-            break;
-        case 115200:
-            cfsetispeed(&options, B115200);
-            cfsetospeed(&options, B115200);
-            break;
-        default:
-            fprintf(stderr, "ERROR: baudrate %d could not be set, aborting\n", baudrate);
-            return -1;
-            break;
-                
-    }
-    LOG__DEBUG("baudrate set to %d", baudrate);
-
 /*
     options.c_cflag |= (CLOCAL | CREAD | CS8);
     options.c_cflag &= ~(PARENB | CSTOPB | CSIZE);
@@ -117,6 +122,13 @@ int openSerial(const char* device, int baudrate) {
     options.c_cflag |= CS8;                    // 8 Datenbits
     options.c_cflag |= CLOCAL | CREAD;         // Lokal, Empfang aktivieren
 
+    // RTS/CTS: the radio stops us before its buffer overflows
+    if (opt->rtscts) {
+        options.c_cflag |= CRTSCTS;
+    } else {
+        options.c_cflag &= ~CRTSCTS;
+    }
+
     // Input Flags: keine Umwandlungen, kein Flow Control
     options.c_iflag &= ~(IXON | IXOFF | IXANY);          // keine SW Flow Control
     options.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | INPCK);
@@ -127,8 +139,12 @@ int openSerial(const char* device, int baudrate) {
     // Local Flags: kein Echo, keine Signale, kein Canonical Mode
     options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG | IEXTEN);
 
-    // Blocking Read: warte auf 1 Zeichen, kein Timeout
-    options.c_cc[VMIN] = 1;
+    // the fd is non-blocking, VMIN sets how many bytes make it readable for
+    // epoll (VTIME must be 0 for that). 1 = every byte wakes us up.
+    int vmin = opt->read_batch;
+    if (vmin < 1) vmin = 1;
+    if (vmin > 255) vmin = 255;
+    options.c_cc[VMIN] = vmin;
     options.c_cc[VTIME] = 0;
 
 /*
@@ -139,30 +155,451 @@ int openSerial(const char* device, int baudrate) {
         return -1;
     }
 
-    if (pthread_mutex_init(&lock_tty, NULL) != 0) {
-        fprintf(stderr, "%s: create a mutex failed\n", progname);
+    // standard Bxxx rate or any other rate the driver can make (termios2)
+    int applied = baudrate_set(fd, baudrate);
+    if (applied <= 0) {
+        fprintf(stderr, "ERROR: baudrate %d could not be set, aborting\n", baudrate);
+        return -1;
+    }
+    if (applied != baudrate) {
+        LOG__WARN("serial port %s: baudrate %d requested, driver applied %d", device, baudrate, applied);
+    }
+    LOG__DEBUG("baudrate set to %d%s", applied, baudrate_is_standard(baudrate) ? "" : " (BOTHER)");
+
+    memset(port, 0, sizeof (*port));
+    if (ringbuf_init(&port->tx, SERIAL_TX_BUFFER_SIZE) < 0) {
+        fprintf(stderr, "%s: allocate tx buffer failed\n", progname);
+        close(fd);
         return -1;
     }
+    port->tx_high_water = SERIAL_TX_HIGH_WATER;
+    port->fd = fd;
+    port->baudrate = applied;      // the pacer works with the real line rate
+    port->char_bits = SERIAL_CHAR_BITS;
+    port->opt = *opt;
+    port->opt.read_batch = vmin;
+    if (vmin > 1 && port->opt.read_wait_ms <= 0) {
+        port->opt.read_wait_ms = SERIAL_READ_WAIT_MS;
+    }
+    strncpy(port->device, device, sizeof (port->device) - 1);
+    if (opt->low_latency) {
+        port->low_latency = set_low_latency(fd, device);
+    }
+    LOG__INFO("serial port %s: low latency %s, rts/cts %s, read batch %d bytes / %d ms", device,
+            port->low_latency ? "on" : "off", opt->rtscts ? "on" : "off", vmin, port->opt.read_wait_ms);
 
     return fd;
 }
 
-int readSerial(int fd, uint8_t* buffer, int buffer_size) {
-    pthread_mutex_lock(&lock_tty);
-    int bytesRead = read(fd, buffer, buffer_size);
-    pthread_mutex_unlock(&lock_tty);
+int readSerial(serial_port_t* port, uint8_t* buffer, int buffer_size) {
+    int bytesRead = read(port->fd, buffer, buffer_size);
+    if (bytesRead > 0) {
+        port->stats.rx_bytes += bytesRead;
+        port->stats.reads++;
+        if ((uint32_t) bytesRead > port->stats.read_max) {
+            port->stats.read_max = bytesRead;
+        }
+    }
     return bytesRead;
 }
 
-int writeSerial(int fd, uint8_t* buffer, int len) {
-    pthread_mutex_lock(&lock_tty);
-    int bytesWrite = write(fd, buffer, len);
-    tcdrain(fd);
-    pthread_mutex_unlock(&lock_tty);
-    return bytesWrite;
+/**
+ * write queued bytes to the tty until it would block
+ * @param port
+ * @return bytes still queued
+ */
+static int flush_tx(serial_port_t* port) {
+    const uint8_t *data;
+    size_t len;
+
+    while ((len = ringbuf_peek(&port->tx, &data)) > 0) {
+        ssize_t bytesWrite = write(port->fd, data, len);
+        if (bytesWrite > 0) {
+            ringbuf_consume(&port->tx, bytesWrite);
+            port->stats.tx_bytes += bytesWrite;
+            continue;
+        }
+        if (bytesWrite < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesWrite < 0 && errno != EAGAIN) {
+            LOG__ERROR("write serial port %s: %s", port->device, strerror(errno));
+        }
+        break;
+    }
+    return ringbuf_used(&port->tx);
+}
+
+/*
+ * Threaded mode: a reader thread reads the tty and frames the bytes, a writer
+ * thread writes the frames the event loop hands over. Both are connected to
+ * the event loop by a lock-free SPSC ring per direction, the event loop keeps
+ * the routing, the scheduler and the pacer. No lock is taken on the way.
+ */
+
+static void signal_fd(int fd) {
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof (one)) < 0) {
+        // the counter is read by the other side, it can't overflow
+    }
+}
+
+static void port_failed(serial_port_t* port) {
+    __atomic_store_n(&port->failed, true, __ATOMIC_RELEASE);
+    signal_fd(port->notify_fd);
+}
+
+/**
+ * copy a frame into the next rx slot. data and payload of the slot frame
+ * point into the slot itself, the slot memory never moves.
+ * A full ring is waited for, the tty buffers the next bytes meanwhile.
+ * @return false if the frame was dropped because the port is closed
+ */
+static bool hand_to_loop(serial_port_t* port, const mav_frame_t* frame) {
+    serial_slot_t *slot;
+    while ((slot = spsc_claim(&port->rx_ring)) == NULL) {
+        signal_fd(port->notify_fd);
+        struct pollfd pfd = {port->stop_fd, POLLIN, 0};
+        if (poll(&pfd, 1, SERIAL_RING_WAIT_MS) > 0) {
+            port->stats.rx_dropped++;
+            return false;
+        }
+    }
+    memcpy(slot->buf, frame->data, frame->len);
+    slot->len = frame->len;
+    slot->frame = *frame;
+    slot->frame.data = slot->buf;
+    slot->frame.payload = slot->buf + (frame->payload - frame->data);
+    spsc_publish(&port->rx_ring);
+    return true;
+}
+
+static void* reader_thread(void* arg) {
+    serial_port_t *port = arg;
+    struct pollfd pfd[2] = {
+        {port->fd, POLLIN, 0},
+        {port->stop_fd, POLLIN, 0},
+    };
+    // batched reads: the rest below VMIN is picked up after the wait time
+    int timeout = port->opt.read_batch > 1 ? port->opt.read_wait_ms : -1;
+
+    for (;;) {
+        int n = poll(pfd, 2, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG__ERROR("serial port %s: poll: %s", port->device, strerror(errno));
+            port_failed(port);
+            break;
+        }
+        if (pfd[1].revents) {
+            break;
+        }
+        if (pfd[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            LOG__ERROR("serial port %s: hangup or error", port->device);
+            port_failed(port);
+            break;
+        }
+
+        int frames = 0;
+        for (;;) {
+            int space;
+            uint8_t *wp = framer_write_ptr(port->framer, &space);
+            int len = readSerial(port, wp, space);
+            if (len <= 0) {
+                if (len == 0 || (errno != EAGAIN && errno != EINTR)) {
+                    LOG__ERROR("read %s: %s", port->device, len == 0 ? "end of stream" : strerror(errno));
+                    port_failed(port);
+                    return NULL;
+                }
+                break;
+            }
+            framer_commit(port->framer, len);
+            mav_frame_t frame;
+            while (framer_next(port->framer, &frame)) {
+                frames += hand_to_loop(port, &frame);
+            }
+        }
+        if (frames > 0) {
+            signal_fd(port->notify_fd);
+        }
+    }
+    return NULL;
+}
+
+static void* writer_thread(void* arg) {
+    serial_port_t *port = arg;
+    struct pollfd pfd[3] = {
+        {port->wake_fd, POLLIN, 0},
+        {port->stop_fd, POLLIN, 0},
+        {port->fd, 0, 0},
+    };
+
+    for (;;) {
+        __atomic_store_n(&port->writer_idle, false, __ATOMIC_SEQ_CST);
+
+        serial_slot_t *slot;
+        bool blocked = false;
+        while ((slot = spsc_front(&port->tx_ring)) != NULL) {
+            ssize_t n = write(port->fd, slot->buf + port->tx_done, slot->len - port->tx_done);
+            if (n > 0) {
+                __atomic_add_fetch(&port->stats.tx_bytes, n, __ATOMIC_RELEASE);
+                port->tx_done += n;
+                if (port->tx_done == slot->len) {
+                    port->tx_done = 0;
+                    spsc_pop(&port->tx_ring);
+                }
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && errno != EAGAIN) {
+                LOG__ERROR("write serial port %s: %s", port->device, strerror(errno));
+            }
+            blocked = true;
+            break;
+        }
+
+        if (!blocked) {
+            // the event loop holds frames back until the ring is drained
+            if (__atomic_exchange_n(&port->tx_wait, false, __ATOMIC_SEQ_CST)) {
+                signal_fd(port->notify_fd);
+            }
+            // frames handed over after the check above come with a wake_fd signal
+            __atomic_store_n(&port->writer_idle, true, __ATOMIC_SEQ_CST);
+            if (!spsc_empty(&port->tx_ring)) {
+                continue;
+            }
+        }
+        pfd[2].events = blocked ? POLLOUT : 0;
+
+        if (poll(pfd, 3, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOG__ERROR("serial port %s: poll: %s", port->device, strerror(errno));
+            port_failed(port);
+            break;
+        }
+        if (pfd[1].revents) {
+            break;
+        }
+        if (pfd[2].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            LOG__ERROR("serial port %s: hangup or error", port->device);
+            port_failed(port);
+            break;
+        }
+        if (pfd[0].revents & POLLIN) {
+            uint64_t count;
+            if (read(port->wake_fd, &count, sizeof (count)) < 0) {
+                // nothing pending
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * event loop side of the tx ring
+ * @return len or -1 if the ring is full
+ */
+static int hand_to_writer(serial_port_t* port, const uint8_t* buffer, int len) {
+    serial_slot_t *slot = spsc_claim(&port->tx_ring);
+    if (!slot || len > (int) sizeof (slot->buf)) {
+        port->stats.tx_dropped++;
+        LOG__DEBUG("serial port %s: tx ring full, frame dropped", port->device);
+        return -1;
+    }
+    memcpy(slot->buf, buffer, len);
+    slot->len = len;
+    spsc_publish(&port->tx_ring);
+    port->tx_handed += len;
+    port->stats.tx_frames++;
+
+    size_t queued = queuedSerial(port);
+    if (queued > port->stats.tx_queue_max) {
+        port->stats.tx_queue_max = queued;
+    }
+    if (__atomic_exchange_n(&port->writer_idle, false, __ATOMIC_SEQ_CST)) {
+        signal_fd(port->wake_fd);
+    }
+    return len;
+}
+
+static void release_threads(serial_port_t* port) {
+    if (port->notify_fd >= 0) close(port->notify_fd);
+    if (port->wake_fd >= 0) close(port->wake_fd);
+    if (port->stop_fd >= 0) close(port->stop_fd);
+    port->notify_fd = port->wake_fd = port->stop_fd = -1;
+    spsc_free(&port->rx_ring);
+    spsc_free(&port->tx_ring);
 }
 
-void closeSerial(int fd) {
-    close(fd);
+static void stop_threads(serial_port_t* port) {
+    signal_fd(port->stop_fd);
+    pthread_join(port->reader, NULL);
+    pthread_join(port->writer, NULL);
+    port->threaded = false;
+    release_threads(port);
 }
 
+/**
+ * start the reader and the writer thread of an opened port. From now on
+ * the event loop gets the frames by receiveSerial() when notify_fd is
+ * readable, writeSerial() hands frames to the writer.
+ * @param port
+ * @param framer used by the reader thread until the port is closed
+ * @return 0 if ok
+ */
+int startSerial(serial_port_t* port, framer_t* framer) {
+    port->framer = framer;
+    port->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    port->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    port->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (port->notify_fd < 0 || port->wake_fd < 0 || port->stop_fd < 0 ||
+            spsc_init(&port->rx_ring, SERIAL_RING_SLOTS, sizeof (serial_slot_t)) < 0 ||
+            spsc_init(&port->tx_ring, SERIAL_RING_SLOTS, sizeof (serial_slot_t)) < 0) {
+        LOG__ERROR("serial port %s: setup of the threads failed: %s", port->device, strerror(errno));
+        release_threads(port);
+        return -1;
+    }
+
+    // signals are handled by the event loop (signalfd), not by the threads
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&port->reader, NULL, reader_thread, port);
+    if (err == 0) {
+        err = pthread_create(&port->writer, NULL, writer_thread, port);
+        if (err != 0) {
+            signal_fd(port->stop_fd);
+            pthread_join(port->reader, NULL);
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        LOG__ERROR("serial port %s: create thread failed: %s", port->device, strerror(err));
+        release_threads(port);
+        return -1;
+    }
+    port->threaded = true;
+    LOG__INFO("serial port %s: reader and writer thread started", port->device);
+    return 0;
+}
+
+/**
+ * next frame of the reader thread
+ * @param port
+ * @return frame, valid until releaseSerial(), NULL if none
+ */
+const mav_frame_t* receiveSerial(serial_port_t* port) {
+    serial_slot_t *slot = spsc_front(&port->rx_ring);
+    return slot ? &slot->frame : NULL;
+}
+
+void releaseSerial(serial_port_t* port) {
+    spsc_pop(&port->rx_ring);
+}
+
+/**
+ * the event loop holds frames back until the writer has drained the tx ring,
+ * notify_fd is signalled then
+ * @param port
+ * @return false if the ring is drained already, don't wait
+ */
+bool waitSerial(serial_port_t* port) {
+    __atomic_store_n(&port->tx_wait, true, __ATOMIC_SEQ_CST);
+    if (spsc_empty(&port->tx_ring)) {
+        // a signal of the writer in between is only an extra wakeup
+        __atomic_store_n(&port->tx_wait, false, __ATOMIC_SEQ_CST);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @param port
+ * @return true if the reader or writer thread lost the port
+ */
+bool failedSerial(serial_port_t* port) {
+    return __atomic_load_n(&port->failed, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * queue a complete frame for the tty and write as much as possible.
+ * The rest is written by flushSerial() when the tty is writable again.
+ *
+ * @param port
+ * @param buffer
+ * @param len
+ * @return len or -1 if the frame was dropped at the high-water mark
+ */
+int writeSerial(serial_port_t* port, const uint8_t* buffer, int len) {
+    if (port->threaded) {
+        return hand_to_writer(port, buffer, len);
+    }
+
+    size_t used = ringbuf_used(&port->tx);
+    if (used + len > port->tx_high_water) {
+        port->stats.tx_dropped++;
+        LOG__DEBUG("serial port %s: tx queue full (%u bytes), frame dropped", port->device, (unsigned) used);
+        return -1;
+    }
+
+    ringbuf_write(&port->tx, buffer, len);
+    port->stats.tx_frames++;
+    used += len;
+    if (used > port->stats.tx_queue_max) {
+        port->stats.tx_queue_max = used;
+    }
+
+    flush_tx(port);
+    return len;
+}
+
+/**
+ * called when the tty is writable again (EPOLLOUT)
+ * @param port
+ * @return bytes still queued
+ */
+int flushSerial(serial_port_t* port) {
+    return flush_tx(port);
+}
+
+/**
+ * bytes accepted by writeSerial() but not yet written to the tty
+ * @param port
+ * @return
+ */
+size_t queuedSerial(serial_port_t* port) {
+    if (port->threaded) {
+        return port->tx_handed - __atomic_load_n(&port->stats.tx_bytes, __ATOMIC_ACQUIRE);
+    }
+    return ringbuf_used(&port->tx);
+}
+
+void closeSerial(serial_port_t* port) {
+    if (port->threaded) {
+        stop_threads(port);
+    }
+    close(port->fd);
+    port->fd = -1;
+    ringbuf_free(&port->tx);
+}
+
+/**
+ * log the queue statistics
+ * @param port
+ */
+void statusSerial(serial_port_t* port) {
+    LOG__INFO("serial port %s: rx %llu bytes, tx %llu bytes, %u frames, %u dropped, queue %u/%u (max %u)",
+            port->device,
+            (unsigned long long) port->stats.rx_bytes, (unsigned long long) port->stats.tx_bytes,
+            port->stats.tx_frames, port->stats.tx_dropped,
+            (unsigned) queuedSerial(port), (unsigned) port->tx_high_water, port->stats.tx_queue_max);
+    // syscalls per byte of the read strategy
+    LOG__INFO("serial port %s: %u reads, %.1f bytes/read, max %u",
+            port->device, port->stats.reads,
+            port->stats.reads ? (double) port->stats.rx_bytes / port->stats.reads : 0.0, port->stats.read_max);
+    if (port->threaded) {
+        LOG__INFO("serial port %s: threaded, %u frames dropped at close", port->device, port->stats.rx_dropped);
+    }
+}
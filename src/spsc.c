@@ -0,0 +1,64 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   spsc.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "spsc.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * allocate the slots. Every slot starts on its own cache line, so writing
+ * one slot never touches the line of the slot the other thread reads.
+ * @param q
+ * @param count rounded up to a power of two
+ * @param slot_size bytes per slot
+ * @return 0 if ok
+ */
+int spsc_init(spsc_t *q, uint32_t count, uint32_t slot_size) {
+    uint32_t n = 1;
+    while (n < count) n <<= 1;
+    uint32_t size = (slot_size + SPSC_CACHE_LINE - 1) & ~(uint32_t) (SPSC_CACHE_LINE - 1);
+
+    memset(q, 0, sizeof (*q));
+    void *slots;
+    if (posix_memalign(&slots, SPSC_CACHE_LINE, (size_t) n * size) != 0) {
+        return -1;
+    }
+    memset(slots, 0, (size_t) n * size);
+    q->slots = slots;
+    q->mask = n - 1;
+    q->slot_size = size;
+    return 0;
+}
+
+void spsc_free(spsc_t *q) {
+    free(q->slots);
+    q->slots = NULL;
+    q->head = q->tail = 0;
+    q->head_cache = q->tail_cache = 0;
+}
@@ -0,0 +1,517 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   tunnel.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "tunnel.h"
+#include "common/mavlink.h"
+#include <string.h>
+#include <time.h>
+
+/*
+ * Codec for the tunnel between mavrptclient and mavrptserver. A codec
+ * datagram is
+ *
+ *   magic, version, epoch, record, record, ...
+ *
+ * and a record is a frame without STX and checksum:
+ *
+ *   flags [sysid compid] [seq] [compat] msgid(1 or 3) payload_len
+ *         key payload | key delta
+ *
+ * sysid/compid are left out if they are the same as in the record before,
+ * seq if it is the one after the record before. Both only refer to the same
+ * datagram. A delta is a list of (skip, count, bytes) against the last full
+ * payload (key) of the stream. The receiver rebuilds the frame and
+ * calculates the checksum again. Unknown messages and signed frames are
+ * sent as raw records.
+ */
+
+#define REC_SRC     0x01    // sysid, compid follow
+#define REC_SEQ     0x02    // seq follows
+#define REC_V1      0x04    // MAVLink v1 frame
+#define REC_MSGID24 0x08    // msgid has 3 bytes
+#define REC_DELTA   0x10    // payload is a delta against the key
+#define REC_KEY     0x20    // payload is the new key of the stream
+#define REC_COMPAT  0x40    // compat flags follow (v2)
+#define REC_RAW     0x80    // length (2 bytes) and the frame as it is
+
+#define REC_MAX_HEADER 10   // flags, src, seq, compat, msgid, payload_len, key
+
+static uint8_t next_epoch;
+
+/**
+ * start a new encoder context, the peer drops its references when it sees
+ * the new epoch
+ */
+static void new_epoch(tunnel_t *t) {
+    if (next_epoch == 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        next_epoch = (uint8_t) (ts.tv_nsec >> 10);
+    }
+    if (++next_epoch == 0) next_epoch = 1;
+    t->epoch = next_epoch;
+    memset(t->tx, 0, sizeof (t->tx));
+}
+
+/**
+ * prepare the codec of a peer, it starts with raw frames until the peer
+ * agrees on a version
+ * @param t
+ * @param stats counters, shared by the peers of a link
+ */
+void tunnel_init(tunnel_t *t, tunnel_stats_t *stats) {
+    memset(t, 0, sizeof (*t));
+    t->stats = stats;
+    framer_init(&t->raw);
+    new_epoch(t);
+}
+
+/**
+ * offer the codec to the peer
+ * @param out buffer of TUNNEL_CONTROL_LEN bytes
+ * @return length of the handshake datagram
+ */
+int tunnel_hello(uint8_t *out) {
+    out[0] = TUNNEL_MAGIC;
+    out[1] = TUNNEL_CONTROL;
+    out[2] = TUNNEL_HELLO;
+    out[3] = TUNNEL_VERSION;
+    return TUNNEL_CONTROL_LEN;
+}
+
+/**
+ * handle a handshake datagram. Both sides use the lower of the two versions.
+ * @param t
+ * @param data
+ * @param len
+ * @param reply buffer of TUNNEL_CONTROL_LEN bytes
+ * @return length of the reply to send, 0 = none
+ */
+int tunnel_control(tunnel_t *t, const uint8_t *data, int len, uint8_t *reply) {
+    if (len < TUNNEL_CONTROL_LEN || data[1] != TUNNEL_CONTROL || data[3] == 0) {
+        return 0;
+    }
+    uint8_t version = data[3] < TUNNEL_VERSION ? data[3] : TUNNEL_VERSION;
+
+    switch (data[2]) {
+        case TUNNEL_HELLO:
+            // the peer has (re)started, it knows none of our keys
+            new_epoch(t);
+            t->version = version;
+            reply[0] = TUNNEL_MAGIC;
+            reply[1] = TUNNEL_CONTROL;
+            reply[2] = TUNNEL_HELLO_ACK;
+            reply[3] = version;
+            return TUNNEL_CONTROL_LEN;
+
+        case TUNNEL_HELLO_ACK:
+            t->version = version;
+            return 0;
+    }
+    return 0;
+}
+
+static inline uint32_t stream_index(uint8_t sysid, uint8_t compid, uint32_t msgid) {
+    return ((msgid * 31 + sysid) * 31 + compid) & (TUNNEL_STREAMS - 1);
+}
+
+static inline bool stream_is(const tunnel_stream_t *s, uint8_t sysid, uint8_t compid, uint32_t msgid) {
+    return s->valid && s->sysid == sysid && s->compid == compid && s->msgid == msgid;
+}
+
+static inline uint8_t ref_byte(const tunnel_stream_t *s, int i) {
+    return i < s->len ? s->payload[i] : 0;
+}
+
+/**
+ * segments (skip, count, bytes) from the key to the payload. Runs of less
+ * than 3 unchanged bytes stay inside a segment, a new one costs 2 bytes.
+ * @return length of the delta, -1 if it is not shorter than limit
+ */
+static int encode_delta(const tunnel_stream_t *key, const uint8_t *payload, int plen, uint8_t *out, int limit) {
+    int pos = 0;
+    int n = 0;
+
+    while (pos < plen) {
+        int skip = 0;
+        while (pos + skip < plen && payload[pos + skip] == ref_byte(key, pos + skip)) {
+            skip++;
+        }
+        pos += skip;
+
+        int count = 0;
+        while (pos + count < plen) {
+            if (payload[pos + count] != ref_byte(key, pos + count)) {
+                count++;
+                continue;
+            }
+            int same = 0;
+            while (same < 3 && pos + count + same < plen &&
+                    payload[pos + count + same] == ref_byte(key, pos + count + same)) {
+                same++;
+            }
+            if (same == 3 || pos + count + same == plen) {
+                break;
+            }
+            count += same;
+        }
+
+        if (n + 2 + count >= limit) {
+            return -1;
+        }
+        out[n++] = (uint8_t) skip;
+        out[n++] = (uint8_t) count;
+        memcpy(out + n, payload + pos, count);
+        n += count;
+        pos += count;
+    }
+    return n;
+}
+
+/**
+ * payload of a compressed record: delta against the key of the stream if
+ * that is shorter, otherwise the payload as new key
+ */
+static uint8_t* encode_payload(tunnel_t *t, const mav_frame_t *frame, uint8_t *q, uint8_t *flags) {
+    tunnel_stream_t *s = &t->tx[stream_index(frame->sysid, frame->compid, frame->msgid)];
+    int plen = frame->payload_len;
+
+    if (stream_is(s, frame->sysid, frame->compid, frame->msgid) && s->since_key < TUNNEL_KEY_INTERVAL) {
+        int n = encode_delta(s, frame->payload, plen, q + 1, plen);
+        if (n >= 0) {
+            *flags |= REC_DELTA;
+            *q = s->key;
+            s->since_key++;
+            t->stats->deltas++;
+            return q + 1 + n;
+        }
+    }
+
+    if (!stream_is(s, frame->sysid, frame->compid, frame->msgid)) {
+        s->valid = true;
+        s->sysid = frame->sysid;
+        s->compid = frame->compid;
+        s->msgid = frame->msgid;
+    }
+    s->key++;
+    s->since_key = 0;
+    s->len = (uint8_t) plen;
+    memcpy(s->payload, frame->payload, plen);
+
+    *flags |= REC_KEY;
+    *q++ = s->key;
+    memcpy(q, frame->payload, plen);
+    t->stats->keys++;
+    return q + plen;
+}
+
+/**
+ * append a frame to the datagram being built
+ * @param t
+ * @param frame
+ * @param mtu max. datagram size
+ * @return 0 if ok, -1 if the datagram is full: send it and try again
+ */
+int tunnel_encode(tunnel_t *t, const mav_frame_t *frame, int mtu) {
+    bool raw = !frame->entry || (frame->incompat_flags & MAVLINK_IFLAG_SIGNED);
+    int need = raw ? 3 + frame->len : REC_MAX_HEADER + frame->payload_len;
+
+    if (mtu < TUNNEL_HEADER_LEN + 3 + MAVLINK_MAX_PACKET_LEN) {
+        mtu = TUNNEL_HEADER_LEN + 3 + MAVLINK_MAX_PACKET_LEN;   // one frame always fits
+    } else if (mtu > UDP_DATAGRAM_SIZE) {
+        mtu = UDP_DATAGRAM_SIZE;
+    }
+    if (t->out_len == 0) {
+        t->out[0] = TUNNEL_MAGIC;
+        t->out[1] = t->version;
+        t->out[2] = t->epoch;
+        t->out_len = TUNNEL_HEADER_LEN;
+    }
+    if (t->out_len + need > mtu) {
+        return -1;
+    }
+
+    bool first = (t->out_len == TUNNEL_HEADER_LEN);
+    uint8_t *p = t->out + t->out_len;
+    uint8_t *q = p + 1;
+    uint8_t flags = 0;
+
+    if (raw) {
+        flags = REC_RAW;
+        *q++ = (uint8_t) (frame->len & 0xFF);
+        *q++ = (uint8_t) (frame->len >> 8);
+        memcpy(q, frame->data, frame->len);
+        q += frame->len;
+    } else {
+        if (first || frame->sysid != t->out_sysid || frame->compid != t->out_compid) {
+            flags |= REC_SRC;
+            *q++ = frame->sysid;
+            *q++ = frame->compid;
+        }
+        if (first || frame->seq != (uint8_t) (t->out_seq + 1)) {
+            flags |= REC_SEQ;
+            *q++ = frame->seq;
+        }
+        if (frame->version == 1) {
+            flags |= REC_V1;
+        } else if (frame->data[3] != 0) {
+            flags |= REC_COMPAT;
+            *q++ = frame->data[3];
+        }
+        if (frame->msgid > 0xFF) {
+            flags |= REC_MSGID24;
+            *q++ = (uint8_t) (frame->msgid & 0xFF);
+            *q++ = (uint8_t) ((frame->msgid >> 8) & 0xFF);
+            *q++ = (uint8_t) ((frame->msgid >> 16) & 0xFF);
+        } else {
+            *q++ = (uint8_t) frame->msgid;
+        }
+        *q++ = frame->payload_len;
+        q = encode_payload(t, frame, q, &flags);
+    }
+    *p = flags;
+
+    t->out_sysid = frame->sysid;
+    t->out_compid = frame->compid;
+    t->out_seq = frame->seq;
+    t->stats->tx_frames++;
+    t->stats->raw_bytes += frame->len;
+    t->stats->coded_bytes += (q - p) + (first ? TUNNEL_HEADER_LEN : 0);
+    t->out_len = (int) (q - t->out);
+    return 0;
+}
+
+/**
+ * the datagram has been sent, the next frame starts a new one
+ */
+void tunnel_sent(tunnel_t *t) {
+    t->out_len = 0;
+    t->queued = false;
+}
+
+/**
+ * decode a codec datagram with tunnel_next()
+ * @param t
+ * @param data must be valid until the last frame is taken
+ * @param len
+ * @return false if it is no data datagram of a known version
+ */
+bool tunnel_attach(tunnel_t *t, const uint8_t *data, int len) {
+    t->in_pos = t->in_len = 0;
+    if (len < TUNNEL_HEADER_LEN || data[1] == TUNNEL_CONTROL || data[1] > TUNNEL_VERSION) {
+        return false;
+    }
+    if (data[2] != t->rx_epoch) {
+        // the peer has restarted its encoder, the keys are gone
+        memset(t->rx, 0, sizeof (t->rx));
+        t->rx_epoch = data[2];
+    }
+    if (t->version == 0) {
+        t->version = data[1];   // the peer sends the codec, so it understands it
+    }
+    t->in = data;
+    t->in_len = len;
+    t->in_pos = TUNNEL_HEADER_LEN;
+    return true;
+}
+
+/**
+ * rebuild header and checksum of a compressed record in t->frame
+ */
+static void build_frame(tunnel_t *t, mav_frame_t *frame, uint8_t version, uint8_t compat, uint32_t msgid, uint8_t plen) {
+    uint8_t *out = t->frame;
+    int header_len;
+
+    if (version == 1) {
+        header_len = MAVLINK_V1_HEADER_LEN;
+        out[0] = MAVLINK_STX_MAVLINK1;
+        out[1] = plen;
+        out[2] = t->in_seq;
+        out[3] = t->in_sysid;
+        out[4] = t->in_compid;
+        out[5] = (uint8_t) msgid;
+    } else {
+        header_len = MAVLINK_V2_HEADER_LEN;
+        out[0] = MAVLINK_STX;
+        out[1] = plen;
+        out[2] = 0;
+        out[3] = compat;
+        out[4] = t->in_seq;
+        out[5] = t->in_sysid;
+        out[6] = t->in_compid;
+        out[7] = (uint8_t) (msgid & 0xFF);
+        out[8] = (uint8_t) ((msgid >> 8) & 0xFF);
+        out[9] = (uint8_t) ((msgid >> 16) & 0xFF);
+    }
+    uint16_t crc = crc_calculate(out + 1, header_len - 1 + plen);
+    crc_accumulate(frame->entry->crc_extra, &crc);
+    out[header_len + plen] = (uint8_t) (crc & 0xFF);
+    out[header_len + plen + 1] = (uint8_t) (crc >> 8);
+
+    frame->data = out;
+    frame->payload = out + header_len;
+    frame->len = header_len + plen + MAVLINK_NUM_CHECKSUM_BYTES;
+    frame->version = version;
+    frame->payload_len = plen;
+    frame->incompat_flags = 0;
+    frame->seq = t->in_seq;
+    frame->sysid = t->in_sysid;
+    frame->compid = t->in_compid;
+    frame->msgid = msgid;
+}
+
+#define NEED(n) do { if (end - q < (n)) goto bad; } while (0)
+
+/**
+ * next frame of the attached datagram
+ * @param t
+ * @param frame valid until the next call
+ * @return false at the end of the datagram
+ */
+bool tunnel_next(tunnel_t *t, mav_frame_t *frame) {
+    const uint8_t *end = t->in + t->in_len;
+
+    while (t->in_pos < t->in_len) {
+        const uint8_t *q = t->in + t->in_pos;
+        bool first = (t->in_pos == TUNNEL_HEADER_LEN);
+        uint8_t flags = *q++;
+
+        if (flags & REC_RAW) {
+            NEED(2);
+            int len = q[0] | (q[1] << 8);
+            q += 2;
+            NEED(len);
+            t->in_pos = (int) (q + len - t->in);
+            framer_attach(&t->raw, q, len);
+            if (!framer_next(&t->raw, frame)) {
+                goto bad;
+            }
+            t->in_sysid = frame->sysid;
+            t->in_compid = frame->compid;
+            t->in_seq = frame->seq;
+            t->stats->rx_frames++;
+            return true;
+        }
+
+        if (first && (flags & (REC_SRC | REC_SEQ)) != (REC_SRC | REC_SEQ)) {
+            goto bad;
+        }
+        if (flags & REC_SRC) {
+            NEED(2);
+            t->in_sysid = *q++;
+            t->in_compid = *q++;
+        }
+        if (flags & REC_SEQ) {
+            NEED(1);
+            t->in_seq = *q++;
+        } else {
+            t->in_seq++;
+        }
+        uint8_t compat = 0;
+        if (flags & REC_COMPAT) {
+            NEED(1);
+            compat = *q++;
+        }
+        uint32_t msgid;
+        if (flags & REC_MSGID24) {
+            NEED(3);
+            msgid = q[0] | (q[1] << 8) | ((uint32_t) q[2] << 16);
+            q += 3;
+        } else {
+            NEED(1);
+            msgid = *q++;
+        }
+        NEED(2);
+        uint8_t plen = *q++;
+        uint8_t key = *q++;
+
+        tunnel_stream_t *s = &t->rx[stream_index(t->in_sysid, t->in_compid, msgid)];
+        uint8_t version = (flags & REC_V1) ? 1 : 2;
+        int header_len = (version == 1) ? MAVLINK_V1_HEADER_LEN : MAVLINK_V2_HEADER_LEN;
+        uint8_t *payload = t->frame + header_len;
+        bool have_key = true;
+
+        if (flags & REC_DELTA) {
+            have_key = stream_is(s, t->in_sysid, t->in_compid, msgid) && s->key == key;
+            if (have_key) {
+                int copy = s->len < plen ? s->len : plen;
+                memcpy(payload, s->payload, copy);
+                memset(payload + copy, 0, plen - copy);
+            }
+            int pos = 0;
+            while (pos < plen) {
+                NEED(2);
+                int skip = q[0];
+                int count = q[1];
+                q += 2;
+                if ((skip == 0 && count == 0) || pos + skip + count > plen) {
+                    goto bad;
+                }
+                NEED(count);
+                pos += skip;
+                if (have_key) memcpy(payload + pos, q, count);
+                pos += count;
+                q += count;
+            }
+        } else if (flags & REC_KEY) {
+            NEED(plen);
+            memcpy(payload, q, plen);
+            q += plen;
+            s->valid = true;
+            s->sysid = t->in_sysid;
+            s->compid = t->in_compid;
+            s->msgid = msgid;
+            s->key = key;
+            s->len = plen;
+            memcpy(s->payload, payload, plen);
+        } else {
+            goto bad;
+        }
+        t->in_pos = (int) (q - t->in);
+
+        if (!have_key) {
+            t->stats->no_ref++;     // its key was lost
+            continue;
+        }
+        frame->entry = framer_msg_entry(msgid);
+        if (!frame->entry) {
+            t->stats->bad++;        // the peer knows other messages
+            continue;
+        }
+        build_frame(t, frame, version, compat, msgid, plen);
+        t->stats->rx_frames++;
+        return true;
+    }
+    return false;
+
+bad:
+    t->stats->bad++;
+    t->in_pos = t->in_len;
+    return false;
+}
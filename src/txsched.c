@@ -0,0 +1,293 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   txsched.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+#include "txsched.h"
+#include "logging.h"
+#include "common/mavlink.h"
+#include <string.h>
+
+/*
+ * Priority scheduler in front of a serial port. Frames wait here instead of
+ * in the tty buffer, so a command overtakes a running parameter or log
+ * download. Frames are handed to the port at the line rate (token bucket)
+ * and only TXSCHED_INFLIGHT bytes ahead.
+ */
+
+#define TXSCHED_MASK (TXSCHED_QUEUE_LEN - 1)
+
+static const char *class_names[TXSCHED_CLASSES] = {"control", "telemetry", "param", "mission", "file"};
+
+// share of the bulk classes, in frames of max. size per round
+static const int bulk_weight[TXSCHED_CLASSES] = {0, 0, 2, 2, 1};
+
+/**
+ * prepare the scheduler of a port, the frames are paced to the line rate
+ * @param sched
+ * @param port opened serial port
+ * @param now ms
+ */
+void txsched_init(txsched_t *sched, const serial_port_t *port, uint64_t now) {
+    memset(sched, 0, sizeof (*sched));
+    sched->bulk = TXSCHED_FIRST_BULK;
+    pacer_init(&sched->pacer, port->baudrate, port->char_bits, now);
+}
+
+/**
+ * priority class of a message
+ * @param msgid
+ * @return class
+ */
+TxClass txsched_classify(uint32_t msgid) {
+    switch (msgid) {
+        case MAVLINK_MSG_ID_HEARTBEAT:
+        case MAVLINK_MSG_ID_SET_MODE:
+        case MAVLINK_MSG_ID_MANUAL_CONTROL:
+        case MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE:
+        case MAVLINK_MSG_ID_COMMAND_INT:
+        case MAVLINK_MSG_ID_COMMAND_LONG:
+        case MAVLINK_MSG_ID_COMMAND_ACK:
+        case MAVLINK_MSG_ID_COMMAND_CANCEL:
+        case MAVLINK_MSG_ID_SET_ATTITUDE_TARGET:
+        case MAVLINK_MSG_ID_SET_POSITION_TARGET_LOCAL_NED:
+        case MAVLINK_MSG_ID_SET_POSITION_TARGET_GLOBAL_INT:
+            return TXSCHED_CONTROL;
+
+        case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
+        case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+        case MAVLINK_MSG_ID_PARAM_VALUE:
+        case MAVLINK_MSG_ID_PARAM_SET:
+        case MAVLINK_MSG_ID_PARAM_EXT_REQUEST_READ:
+        case MAVLINK_MSG_ID_PARAM_EXT_REQUEST_LIST:
+        case MAVLINK_MSG_ID_PARAM_EXT_VALUE:
+        case MAVLINK_MSG_ID_PARAM_EXT_SET:
+        case MAVLINK_MSG_ID_PARAM_EXT_ACK:
+            return TXSCHED_PARAM;
+
+        case MAVLINK_MSG_ID_MISSION_REQUEST_PARTIAL_LIST:
+        case MAVLINK_MSG_ID_MISSION_WRITE_PARTIAL_LIST:
+        case MAVLINK_MSG_ID_MISSION_ITEM:
+        case MAVLINK_MSG_ID_MISSION_REQUEST:
+        case MAVLINK_MSG_ID_MISSION_SET_CURRENT:
+        case MAVLINK_MSG_ID_MISSION_REQUEST_LIST:
+        case MAVLINK_MSG_ID_MISSION_COUNT:
+        case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
+        case MAVLINK_MSG_ID_MISSION_ACK:
+        case MAVLINK_MSG_ID_MISSION_REQUEST_INT:
+        case MAVLINK_MSG_ID_MISSION_ITEM_INT:
+            return TXSCHED_MISSION;
+
+        case MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL:
+        case MAVLINK_MSG_ID_LOG_REQUEST_LIST:
+        case MAVLINK_MSG_ID_LOG_ENTRY:
+        case MAVLINK_MSG_ID_LOG_REQUEST_DATA:
+        case MAVLINK_MSG_ID_LOG_DATA:
+        case MAVLINK_MSG_ID_LOG_ERASE:
+        case MAVLINK_MSG_ID_LOG_REQUEST_END:
+            return TXSCHED_FILE;
+
+        default:
+            return TXSCHED_TELEMETRY;
+    }
+}
+
+static inline uint32_t queue_count(const txsched_queue_t *q) {
+    return q->tail - q->head;
+}
+
+static void drop_oldest(txsched_t *sched, txsched_queue_t *q) {
+    txsched_entry_t *e = &q->entries[q->head++ & TXSCHED_MASK];
+    q->bytes -= e->fb->frame.len;
+    sched->bytes -= e->fb->frame.len;
+    q->dropped++;
+    framebuf_unref(e->fb);
+}
+
+static framebuf_t* take(txsched_t *sched, int c) {
+    txsched_queue_t *q = &sched->queue[c];
+    txsched_entry_t *e = &q->entries[q->head++ & TXSCHED_MASK];
+    int len = e->fb->frame.len;
+    q->bytes -= len;
+    sched->bytes -= len;
+    if (c >= TXSCHED_FIRST_BULK) {
+        q->deficit -= len;
+    }
+    q->sent++;
+    return e->fb;
+}
+
+/**
+ * queue a frame for the port. A full class queue loses its oldest frame.
+ * If the queued bytes need longer than TXSCHED_BUDGET_MS at the paced rate,
+ * the oldest frames of the lowest priority are dropped.
+ *
+ * @param sched
+ * @param fb frame, a reference is taken
+ * @param now ms
+ * @return 0 if queued
+ */
+int txsched_enqueue(txsched_t *sched, framebuf_t *fb, uint64_t now) {
+    txsched_queue_t *q = &sched->queue[txsched_classify(fb->frame.msgid)];
+
+    if (queue_count(q) == TXSCHED_QUEUE_LEN) {
+        drop_oldest(sched, q);
+    }
+    txsched_entry_t *e = &q->entries[q->tail++ & TXSCHED_MASK];
+    e->fb = framebuf_ref(fb);
+    e->time_ms = now;
+    q->bytes += fb->frame.len;
+    sched->bytes += fb->frame.len;
+
+    if (sched->pacer.rate == 0) {
+        return 0;
+    }
+    uint32_t budget = (uint32_t) ((uint64_t) sched->pacer.rate * TXSCHED_BUDGET_MS / 1000);
+    for (int c = TXSCHED_CLASSES - 1; c >= 0 && sched->bytes > budget; c--) {
+        txsched_queue_t *low = &sched->queue[c];
+        while (queue_count(low) > 0 && sched->bytes > budget) {
+            drop_oldest(sched, low);
+        }
+    }
+    return 0;
+}
+
+/**
+ * next bulk class by deficit round robin
+ * @return class or -1 if all bulk queues are empty
+ */
+static int next_bulk(txsched_t *sched) {
+    bool any = false;
+    for (int c = TXSCHED_FIRST_BULK; c < TXSCHED_CLASSES; c++) {
+        if (queue_count(&sched->queue[c]) > 0) any = true;
+    }
+    if (!any) {
+        return -1;
+    }
+
+    for (;;) {
+        int c = sched->bulk;
+        txsched_queue_t *q = &sched->queue[c];
+        if (queue_count(q) > 0) {
+            if (!sched->bulk_visited) {
+                q->deficit += bulk_weight[c] * MAVLINK_MAX_PACKET_LEN;
+                sched->bulk_visited = true;
+            }
+            if (q->entries[q->head & TXSCHED_MASK].fb->frame.len <= q->deficit) {
+                return c;
+            }
+        } else {
+            q->deficit = 0;
+        }
+        sched->bulk = (c + 1 < TXSCHED_CLASSES) ? c + 1 : TXSCHED_FIRST_BULK;
+        sched->bulk_visited = false;
+    }
+}
+
+/**
+ * class of the next frame by priority. Frames of the lower classes, which
+ * waited longer than the time budget, are dropped here.
+ * @return class or -1 if nothing is queued
+ */
+static int select_class(txsched_t *sched, uint64_t now) {
+    for (int c = TXSCHED_CONTROL; c < TXSCHED_FIRST_BULK; c++) {
+        txsched_queue_t *q = &sched->queue[c];
+        while (c != TXSCHED_CONTROL && queue_count(q) > 0 &&
+                now - q->entries[q->head & TXSCHED_MASK].time_ms > TXSCHED_BUDGET_MS) {
+            drop_oldest(sched, q);
+        }
+        if (queue_count(q) > 0) {
+            return c;
+        }
+    }
+
+    int c;
+    while ((c = next_bulk(sched)) >= 0) {
+        txsched_queue_t *q = &sched->queue[c];
+        if (now - q->entries[q->head & TXSCHED_MASK].time_ms > TXSCHED_BUDGET_MS) {
+            drop_oldest(sched, q);
+            continue;
+        }
+        return c;
+    }
+    return -1;
+}
+
+/**
+ * hand frames to the serial port while the token bucket allows it and the
+ * port has less than TXSCHED_INFLIGHT bytes queued. Called after enqueue,
+ * when the tty is writable and when the pacing time is over.
+ * @param sched
+ * @param port
+ * @param now ms
+ * @return ms until the next frame may be sent, 0 if not waiting for the pacer
+ */
+int txsched_drain(txsched_t *sched, serial_port_t *port, uint64_t now) {
+    int c;
+    while (sched->bytes > 0 && queuedSerial(port) < TXSCHED_INFLIGHT &&
+            (c = select_class(sched, now)) >= 0) {
+        txsched_queue_t *q = &sched->queue[c];
+        int len = q->entries[q->head & TXSCHED_MASK].fb->frame.len;
+        if (!pacer_take(&sched->pacer, len, now)) {
+            return pacer_wait_ms(&sched->pacer, len);
+        }
+        framebuf_t *fb = take(sched, c);
+        writeSerial(port, fb->frame.data, fb->frame.len);
+        framebuf_unref(fb);
+    }
+    return 0;
+}
+
+/**
+ * log the statistics of the classes
+ * @param sched
+ * @param name of the link
+ */
+void txsched_status(const txsched_t *sched, const char *name) {
+    for (int c = 0; c < TXSCHED_CLASSES; c++) {
+        const txsched_queue_t *q = &sched->queue[c];
+        LOG__INFO("%s: tx %-9s %u sent, %u dropped, %u queued", name, class_names[c],
+                q->sent, q->dropped, queue_count(q));
+    }
+    LOG__INFO("%s: paced to %u bytes/s, %u times waiting for the line", name,
+            sched->pacer.rate, sched->pacer.delayed);
+}
+
+/**
+ * release all queued frames
+ * @param sched
+ */
+void txsched_clear(txsched_t *sched) {
+    for (int c = 0; c < TXSCHED_CLASSES; c++) {
+        txsched_queue_t *q = &sched->queue[c];
+        while (queue_count(q) > 0) {
+            framebuf_unref(q->entries[q->head++ & TXSCHED_MASK].fb);
+        }
+        q->bytes = 0;
+    }
+    sched->bytes = 0;
+}
@@ -29,34 +29,60 @@
 
 #include "udp.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <stdbool.h>
 #include <arpa/inet.h>
-#include <pthread.h>
 
 extern char *progname;
-pthread_mutex_t lock_udp;
 
-int setup_udp_client_socket(const char* remote_ip, int port) {
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+/**
+ * UDP socket "fixiert" auf die Gegenstelle, IPv4 oder IPv6
+ * @param addr
+ * @param addrlen
+ * @return socket or -1
+ */
+int udp_connect(const struct sockaddr* addr, socklen_t addrlen) {
+    int sock = socket(addr->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
     if (sock < 0) return -1;
 
-    struct sockaddr_in addr = {0};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    inet_pton(AF_INET, remote_ip, &addr.sin_addr);
-
-    if (pthread_mutex_init(&lock_udp, NULL) != 0) {
-        fprintf(stderr, "%s: create a mutex failed\n", progname);
+    if (connect(sock, addr, addrlen) < 0) {
+        int err = errno;
+        close(sock);
+        errno = err;
         return -1;
     }
-
-    connect(sock, (struct sockaddr*)&addr, sizeof(addr)); // "fixierte" Verbindung
     return sock;
 }
 
+/**
+ * bind to all addresses. IPv6 sockets accept IPv4 too (v4-mapped),
+ * without IPv6 support the socket falls back to IPv4.
+ * @param port
+ * @return socket or -1
+ */
 int setup_udp_server_socket(int port) {
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sock >= 0) {
+        int off = 0;
+        setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+        struct sockaddr_in6 addr6 = {0};
+        addr6.sin6_family = AF_INET6;
+        addr6.sin6_addr = in6addr_any;
+        addr6.sin6_port = htons(port);
+
+        if (bind(sock, (struct sockaddr*)&addr6, sizeof(addr6)) < 0) {
+            perror("bind");
+            close(sock);
+            return -1;
+        }
+        return sock;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
     if (sock < 0) return -1;
 
     struct sockaddr_in addr = {0};
@@ -64,28 +90,180 @@ int setup_udp_server_socket(int port) {
     addr.sin_addr.s_addr = INADDR_ANY;
     addr.sin_port = htons(port);
 
-    if (pthread_mutex_init(&lock_udp, NULL) != 0) {
-        fprintf(stderr, "%s: create a mutex failed\n", progname);
-        return -1;
-    }
-
     if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         perror("bind");
+        close(sock);
         return -1;
     }
     return sock;
 }
 
-int send_udp_packet(int sockfd, const uint8_t* data, int len) {
-    pthread_mutex_lock(&lock_udp);
-    int bytesWrite = send(sockfd, data, len, 0);
-    pthread_mutex_unlock(&lock_udp);
-    return bytesWrite;
+/**
+ * prepare the message vectors of a batch
+ * @param batch
+ * @param rx allocate receive buffers
+ * @return 0 if ok
+ */
+int udp_batch_init(udp_batch_t* batch, bool rx) {
+    memset(batch->msgs, 0, sizeof (batch->msgs));
+    for (int i = 0; i < UDP_BATCH_SIZE; i++) {
+        batch->msgs[i].msg_hdr.msg_iov = batch->iov[i];
+        batch->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    batch->count = 0;
+    batch->dropped = 0;
+    batch->datagrams = 0;
+    batch->frames = 0;
+    batch->buffer = NULL;
+    if (rx) {
+        batch->buffer = malloc(UDP_BATCH_SIZE * UDP_DATAGRAM_SIZE);
+        if (!batch->buffer) {
+            fprintf(stderr, "%s: allocate udp buffers failed\n", progname);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void udp_batch_free(udp_batch_t* batch) {
+    free(batch->buffer);
+    batch->buffer = NULL;
+}
+
+/**
+ * receive up to UDP_BATCH_SIZE datagrams with one syscall.
+ * Datagram i is in batch->buffer[i], its length in batch->msgs[i].msg_len
+ * and the sender in batch->addr[i].
+ *
+ * @param sockfd
+ * @param batch
+ * @return number of datagrams, -1 on error (EAGAIN if nothing is pending)
+ */
+int udp_recv_batch(int sockfd, udp_batch_t* batch) {
+    for (int i = 0; i < UDP_BATCH_SIZE; i++) {
+        batch->iov[i][0].iov_base = batch->buffer[i];
+        batch->iov[i][0].iov_len = UDP_DATAGRAM_SIZE;
+        batch->msgs[i].msg_hdr.msg_iovlen = 1;
+        batch->msgs[i].msg_hdr.msg_name = &batch->addr[i];
+        batch->msgs[i].msg_hdr.msg_namelen = sizeof (batch->addr[i]);
+    }
+    int n = recvmmsg(sockfd, batch->msgs, UDP_BATCH_SIZE, MSG_DONTWAIT, NULL);
+    batch->count = (n > 0) ? n : 0;
+    return n;
+}
+
+static bool same_addr(const udp_batch_t* batch, int i, const struct sockaddr* addr, socklen_t addrlen) {
+    const struct msghdr *hdr = &batch->msgs[i].msg_hdr;
+    if (!addr) {
+        return hdr->msg_name == NULL;
+    }
+    return hdr->msg_namelen == addrlen && memcmp(hdr->msg_name, addr, addrlen) == 0;
 }
 
-int recv_udp_packet(int sockfd, uint8_t* buffer, int maxlen) {
-    pthread_mutex_lock(&lock_udp);
-    int bytesRead = recv(sockfd, buffer, maxlen, MSG_DONTWAIT); // non-blocking
-    pthread_mutex_unlock(&lock_udp);
-    return bytesRead;
+/**
+ * queue data for udp_send_batch(). The data is not copied. With an mtu the
+ * data is appended to the queued datagram for the same destination as long
+ * as the datagram stays within mtu bytes, otherwise it starts a new one.
+ *
+ * @param batch
+ * @param data
+ * @param len
+ * @param addr destination, NULL for a connected socket
+ * @param addrlen
+ * @param mtu max. datagram size, 0 = one datagram per call
+ * @return position of the data (datagram * UDP_DATAGRAM_FRAMES + piece),
+ *         -1 if the batch or the datagram for the destination is full:
+ *         send the batch and add again
+ */
+int udp_batch_add(udp_batch_t* batch, const uint8_t* data, int len, const struct sockaddr* addr, socklen_t addrlen, int mtu) {
+    if (mtu > 0) {
+        for (int i = batch->count - 1; i >= 0; i--) {
+            if (!same_addr(batch, i, addr, addrlen)) {
+                continue;
+            }
+            struct msghdr *hdr = &batch->msgs[i].msg_hdr;
+            if (batch->len[i] + len > mtu || hdr->msg_iovlen >= UDP_DATAGRAM_FRAMES) {
+                return -1;
+            }
+            int piece = hdr->msg_iovlen++;
+            batch->iov[i][piece].iov_base = (void*) data;
+            batch->iov[i][piece].iov_len = len;
+            batch->len[i] += len;
+            return i * UDP_DATAGRAM_FRAMES + piece;
+        }
+    }
+
+    if (batch->count >= UDP_BATCH_SIZE) {
+        return -1;
+    }
+    int i = batch->count;
+    batch->iov[i][0].iov_base = (void*) data;
+    batch->iov[i][0].iov_len = len;
+    batch->msgs[i].msg_hdr.msg_iovlen = 1;
+    batch->len[i] = len;
+    batch->header[i] = false;
+    if (addr) {
+        memcpy(&batch->addr[i], addr, addrlen);
+        batch->msgs[i].msg_hdr.msg_name = &batch->addr[i];
+        batch->msgs[i].msg_hdr.msg_namelen = addrlen;
+    } else {
+        batch->msgs[i].msg_hdr.msg_name = NULL;
+        batch->msgs[i].msg_hdr.msg_namelen = 0;
+    }
+    batch->count++;
+    return i * UDP_DATAGRAM_FRAMES;
+}
+
+/**
+ * put a header in front of datagram i, e.g. of the FEC layer. Like the
+ * pieces it must be valid until udp_send_batch().
+ * @param batch
+ * @param i datagram
+ * @param data
+ * @param len
+ */
+void udp_batch_prepend(udp_batch_t* batch, int i, const uint8_t* data, int len) {
+    struct msghdr *hdr = &batch->msgs[i].msg_hdr;
+    memmove(&batch->iov[i][1], &batch->iov[i][0], hdr->msg_iovlen * sizeof (struct iovec));
+    batch->iov[i][0].iov_base = (void*) data;
+    batch->iov[i][0].iov_len = len;
+    hdr->msg_iovlen++;
+    batch->len[i] += len;
+    batch->header[i] = true;
+}
+
+/**
+ * send all queued datagrams with as few syscalls as possible.
+ * Datagrams the socket does not take (EAGAIN) are dropped, as UDP would.
+ *
+ * @param sockfd
+ * @param batch
+ * @return number of datagrams sent
+ */
+int udp_send_batch(int sockfd, udp_batch_t* batch) {
+    int sent = 0;
+    bool retried = false;
+    while (sent < batch->count) {
+        int n = sendmmsg(sockfd, batch->msgs + sent, batch->count - sent, MSG_DONTWAIT);
+        if (n > 0) {
+            for (int i = sent; i < sent + n; i++) {
+                batch->frames += batch->msgs[i].msg_hdr.msg_iovlen - (batch->header[i] ? 1 : 0);
+            }
+            batch->datagrams += n;
+            sent += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == ECONNREFUSED && !retried) {
+            // icmp port unreachable of an earlier datagram, try once more
+            retried = true;
+            continue;
+        }
+        batch->dropped += batch->count - sent;
+        break;
+    }
+    batch->count = 0;
+    return sent;
 }
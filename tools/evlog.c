@@ -0,0 +1,170 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2025 Jonny Röker
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File:   evlog.c
+ * Author: jonny
+ *
+ * Created on 17. Oktober 2026
+ */
+
+/*
+ * mavrptevlog: print a binary event log of mavrpt as text or csv
+ *
+ *   mavrptevlog [--csv] file [file...]
+ *
+ * Give the rotated file first (name.old name) to get the events in order.
+ */
+
+#include "eventlog.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+char *progname = "mavrptevlog";
+
+/**
+ * wall clock of a record as "YYYY-mm-dd HH:MM:SS.uuuuuu"
+ */
+static void format_time(const eventlog_header_t *header, uint64_t time_us, char *buf, size_t size) {
+    uint64_t us = header->realtime_us + (time_us - header->monotonic_us);
+    time_t sec = us / 1000000;
+    struct tm t;
+    localtime_r(&sec, &t);
+    size_t n = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &t);
+    snprintf(buf + n, size - n, ".%06u", (unsigned) (us % 1000000));
+}
+
+static void print_text(const eventlog_header_t *header, const eventlog_record_t *rec) {
+    char timebuf[40];
+    format_time(header, rec->time_us, timebuf, sizeof (timebuf));
+    const eventlog_info_t *info = eventlog_info(rec->event);
+
+    printf("%s ", timebuf);
+    if (rec->link == EVENTLOG_NO_LINK) {
+        printf("link -  ");
+    } else {
+        printf("link %-2u ", rec->link);
+    }
+    if (info) {
+        printf("%-14s", info->name);
+    } else {
+        printf("event %-8u", rec->event);
+    }
+    for (int i = 0; i < rec->argc && i < EVENTLOG_ARGS; i++) {
+        if (!info) {
+            printf(" arg%d=%u", i + 1, rec->arg[i]);
+        } else if (info->args[i]) {
+            printf(" %s=%u", info->args[i], rec->arg[i]);
+        }
+    }
+    printf("\n");
+}
+
+static void print_csv(const eventlog_header_t *header, const eventlog_record_t *rec) {
+    char timebuf[40];
+    format_time(header, rec->time_us, timebuf, sizeof (timebuf));
+    const eventlog_info_t *info = eventlog_info(rec->event);
+
+    printf("%llu,%s,", (unsigned long long) rec->time_us, timebuf);
+    if (info) {
+        printf("%s,", info->name);
+    } else {
+        printf("%u,", rec->event);
+    }
+    if (rec->link != EVENTLOG_NO_LINK) {
+        printf("%u", rec->link);
+    }
+    for (int i = 0; i < EVENTLOG_ARGS; i++) {
+        if (i < rec->argc) {
+            printf(",%u", rec->arg[i]);
+        } else {
+            printf(",");
+        }
+    }
+    printf("\n");
+}
+
+/**
+ * print all records of a file
+ * @return 0 if ok
+ */
+static int decode(const char *name, bool csv) {
+    FILE *f = fopen(name, "rb");
+    if (!f) {
+        perror(name);
+        return -1;
+    }
+
+    eventlog_header_t header;
+    if (fread(&header, sizeof (header), 1, f) != 1 ||
+            memcmp(header.magic, EVENTLOG_MAGIC, sizeof (header.magic)) != 0) {
+        fprintf(stderr, "%s: %s is no event log\n", progname, name);
+        fclose(f);
+        return -1;
+    }
+    if (header.version != EVENTLOG_VERSION || header.record_size != sizeof (eventlog_record_t)) {
+        fprintf(stderr, "%s: %s: version %u with %u byte records not supported\n",
+                progname, name, header.version, header.record_size);
+        fclose(f);
+        return -1;
+    }
+
+    eventlog_record_t rec;
+    while (fread(&rec, sizeof (rec), 1, f) == 1 && rec.event != EVENTLOG_NONE) {
+        if (csv) {
+            print_csv(&header, &rec);
+        } else {
+            print_text(&header, &rec);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    bool csv = false;
+    int first = 1;
+    if (argc > 1 && strcmp(argv[1], "--csv") == 0) {
+        csv = true;
+        first = 2;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "Usage: %s [--csv] <eventlog file> [...]\n", progname);
+        return 1;
+    }
+
+    if (csv) {
+        printf("time_us,time,event,link");
+        for (int i = 0; i < EVENTLOG_ARGS; i++) {
+            printf(",arg%d", i + 1);
+        }
+        printf("\n");
+    }
+    int ret = 0;
+    for (int i = first; i < argc; i++) {
+        if (decode(argv[i], csv) < 0) {
+            ret = 1;
+        }
+    }
+    return ret;
+}